@@ -28,13 +28,24 @@ SOURCES += main.cpp\
     histogramwindow.cpp \
     blurwindow.cpp \
     cannywindow.cpp \
+    clahewindow.cpp \
     gradientwindow.cpp \
+    mergewindow.cpp \
     morphologywindow.cpp \
     thresholdwindow.cpp \
     image.cpp \
     imagelabel.cpp \
     setscalewindow.cpp \
     textlistwindow.cpp \
+    componenttree.cpp \
+    measurementmodel.cpp \
+    overlay.cpp \
+    histogramengine.cpp \
+    regionhistogram.cpp \
+    plotmarker.cpp \
+    clahe.cpp \
+    lookuptable.cpp \
+    pointwise.cpp \
     opencv_future/imgproc/src/connectedcomponents.cpp
 
 HEADERS  += mainwindow.h \
@@ -44,13 +55,24 @@ HEADERS  += mainwindow.h \
     histogramwindow.h \
     blurwindow.h \
     cannywindow.h \
+    clahewindow.h \
     gradientwindow.h \
+    mergewindow.h \
     morphologywindow.h \
     thresholdwindow.h \
     image.h \
     imagelabel.h \
     setscalewindow.h \
     textlistwindow.h \
+    componenttree.h \
+    measurementmodel.h \
+    overlay.h \
+    histogramengine.h \
+    regionhistogram.h \
+    plotmarker.h \
+    clahe.h \
+    lookuptable.h \
+    pointwise.h \
     opencv_future/imgproc/connectedcomponents.hpp
 
 FORMS    += mainwindow.ui \
@@ -58,7 +80,9 @@ FORMS    += mainwindow.ui \
     histogramwindow.ui \
     blurwindow.ui \
     cannywindow.ui \
+    clahewindow.ui \
     gradientwindow.ui \
+    mergewindow.ui \
     morphologywindow.ui \
     thresholdwindow.ui \
     image.ui \
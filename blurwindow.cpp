@@ -94,6 +94,8 @@ void BlurWindow::on_sizeSpinBox_valueChanged(int)
 
 void BlurWindow::blur()
 {
+  image->detach();
+
   int size = ui->sizeSpinBox->value();
 
   if (ui->averageRadioButton->isChecked()) {
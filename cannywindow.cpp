@@ -35,6 +35,9 @@ CannyWindow::CannyWindow(Image* image,
 
   image->backup();
 
+  // previous doesn't change while the window is open
+  histogram = image->histogram();
+
   connect(this,   SIGNAL(update()),
           image,  SLOT(update()));
 
@@ -140,6 +143,8 @@ void CannyWindow::on_sizeSpinBox_valueChanged(int)
 
 void CannyWindow::canny()
 {
+  image->detach();
+
   int size = ui->sizeSpinBox->value();
   bool l2norm = ui->l2RadioButton->isChecked();
 
@@ -180,25 +185,11 @@ double CannyWindow::calculateMean()
 
 double CannyWindow::calculateMedian()
 {
-  cv::Mat histogram;
-  int acc = 0;
-  int const size = image->previous.rows * image->previous.cols;
-
-  std::vector<cv::Mat> images;
-  std::vector<int> channels;
-  std::vector<int> histSize;
-  std::vector<float> ranges;
-
-  images.push_back(image->previous);
-  channels.push_back(0);
-  histSize.push_back(256);
-  ranges.push_back(0);
-  ranges.push_back(256);
-
-  cv::calcHist(images, channels, cv::Mat(), histogram, histSize, ranges);
+  unsigned int acc = 0;
+  unsigned int const size = image->previous.rows * image->previous.cols;
 
   for (int i = 0; i < 256; i++) {
-    acc += histogram.at<float>(i);
+    acc += histogram.at(i);
     if (acc > size / 2)
       return i;
   }
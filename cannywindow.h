@@ -21,6 +21,8 @@
 
 #include <QMainWindow>
 
+#include <vector>
+
 class Image;
 
 namespace Ui {
@@ -61,6 +63,7 @@ class CannyWindow : public QMainWindow
     Ui::CannyWindow *ui;
     Image* image;
     bool abort;
+    std::vector<unsigned int> histogram;
 
     void canny();
     double calculateMean();
@@ -0,0 +1,228 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clahe.h"
+
+#include <QtConcurrentMap>
+#include <QVector>
+
+#include <algorithm>
+
+namespace {
+  int const bins = 256;
+
+  // Rows mapped by each task
+  int const bandRows = 64;
+
+  struct Tile {
+      cv::Mat const* image;
+      int left;
+      int right;
+      int top;
+      int bottom;
+      unsigned int* counts;
+  };
+
+  void countTile(Tile& tile)
+  {
+    for (int i = tile.top; i < tile.bottom; i++) {
+      uchar const* p = tile.image->ptr<uchar>(i);
+
+      for (int j = tile.left; j < tile.right; j++)
+        tile.counts[p[j]]++;
+    }
+  }
+
+  struct Band {
+      cv::Mat const* image;
+      cv::Mat* result;
+      uchar const* luts;
+      int tilesX;
+      int tilesY;
+      int const* left;
+      int const* right;
+      float const* xWeight;
+      int first;
+      int last;
+  };
+
+  // Pixels between the centers of the tiles blend the four tables around
+  // them, pixels past the outer centers use the nearest ones. The vertical
+  // blend only depends on the row, so the two rows of tables around it are
+  // first blended into a single row of tables; each pixel then reads two
+  // entries of it and blends them with the weight of its column.
+  void mapBand(Band& band)
+  {
+    int const cols = band.image->cols;
+    int const stride = band.tilesX * bins;
+    float const tileHeight = float(band.image->rows) / band.tilesY;
+
+    std::vector<float> blended(stride);
+
+    for (int i = band.first; i < band.last; i++) {
+      float const y = (i + 0.5f) / tileHeight - 0.5f;
+      int const ty = cvFloor(y);
+      float const ya = y - ty;
+
+      uchar const* top = band.luts + std::max(ty, 0) * stride;
+      uchar const* bottom = band.luts + std::min(ty + 1, band.tilesY - 1) * stride;
+
+      for (int k = 0; k < stride; k++)
+        blended[k] = top[k] + (bottom[k] - top[k]) * ya;
+
+      uchar const* p = band.image->ptr<uchar>(i);
+      uchar* q = band.result->ptr<uchar>(i);
+      float const* row = &blended[0];
+
+      for (int j = 0; j < cols; j++) {
+        float const l = row[band.left[j] + p[j]];
+        float const r = row[band.right[j] + p[j]];
+
+        q[j] = cv::saturate_cast<uchar>(l + (r - l) * band.xWeight[j]);
+      }
+    }
+  }
+}
+
+Clahe::Clahe(cv::Mat const& image, int tilesX, int tilesY) :
+  image(image),
+  tilesX(std::max(1, std::min(tilesX, image.cols))),
+  tilesY(std::max(1, std::min(tilesY, image.rows))),
+  xEdges(this->tilesX + 1),
+  yEdges(this->tilesY + 1),
+  histograms(this->tilesX * this->tilesY * bins, 0)
+{
+  for (int i = 0; i <= this->tilesX; i++)
+    xEdges[i] = i * image.cols / this->tilesX;
+
+  for (int i = 0; i <= this->tilesY; i++)
+    yEdges[i] = i * image.rows / this->tilesY;
+
+  // Each tile is counted by a single task into its own histogram
+  QVector<Tile> tiles;
+
+  for (int ty = 0; ty < this->tilesY; ty++) {
+    for (int tx = 0; tx < this->tilesX; tx++) {
+      Tile tile;
+
+      tile.image = &this->image;
+      tile.left = xEdges[tx];
+      tile.right = xEdges[tx + 1];
+      tile.top = yEdges[ty];
+      tile.bottom = yEdges[ty + 1];
+      tile.counts = &histograms[(ty * this->tilesX + tx) * bins];
+
+      tiles.append(tile);
+    }
+  }
+
+  QtConcurrent::blockingMap(tiles, countTile);
+}
+
+// Same clipping and redistribution as cv::createCLAHE
+void Clahe::equalize(int tile, double clipLimit, uchar* lut) const
+{
+  int const tx = tile % tilesX;
+  int const ty = tile / tilesX;
+  int const area = (xEdges[tx + 1] - xEdges[tx]) *
+                   (yEdges[ty + 1] - yEdges[ty]);
+  unsigned int const* h = &histograms[tile * bins];
+  std::vector<unsigned int> clipped(h, h + bins);
+
+  if (clipLimit > 0) {
+    unsigned int const limit = std::max(1, int(clipLimit * area / bins));
+    unsigned int excess = 0;
+
+    for (int i = 0; i < bins; i++) {
+      if (clipped[i] > limit) {
+        excess += clipped[i] - limit;
+        clipped[i] = limit;
+      }
+    }
+
+    unsigned int const batch = excess / bins;
+    unsigned int residual = excess - batch * bins;
+
+    for (int i = 0; i < bins; i++)
+      clipped[i] += batch;
+
+    if (residual) {
+      int const step = std::max(bins / int(residual), 1);
+
+      for (int i = 0; i < bins && residual; i += step, residual--)
+        clipped[i]++;
+    }
+  }
+
+  float const scale = float(bins - 1) / area;
+  unsigned int sum = 0;
+
+  for (int i = 0; i < bins; i++) {
+    sum += clipped[i];
+    lut[i] = cv::saturate_cast<uchar>(sum * scale);
+  }
+}
+
+void Clahe::apply(double clipLimit, cv::Mat& result) const
+{
+  int const tiles = tilesX * tilesY;
+  int const cols = image.cols;
+  float const tileWidth = float(cols) / tilesX;
+
+  std::vector<uchar> luts(tiles * bins);
+
+  for (int i = 0; i < tiles; i++)
+    equalize(i, clipLimit, &luts[i * bins]);
+
+  std::vector<int> left(cols);
+  std::vector<int> right(cols);
+  std::vector<float> xWeight(cols);
+
+  for (int j = 0; j < cols; j++) {
+    float const x = (j + 0.5f) / tileWidth - 0.5f;
+    int const tx = cvFloor(x);
+
+    xWeight[j] = x - tx;
+    left[j] = std::max(tx, 0) * bins;
+    right[j] = std::min(tx + 1, tilesX - 1) * bins;
+  }
+
+  result.create(image.size(), CV_8UC1);
+
+  QVector<Band> bands;
+
+  for (int first = 0; first < image.rows; first += bandRows) {
+    Band band;
+
+    band.image = &image;
+    band.result = &result;
+    band.luts = &luts[0];
+    band.tilesX = tilesX;
+    band.tilesY = tilesY;
+    band.left = &left[0];
+    band.right = &right[0];
+    band.xWeight = &xWeight[0];
+    band.first = first;
+    band.last = std::min(first + bandRows, image.rows);
+
+    bands.append(band);
+  }
+
+  QtConcurrent::blockingMap(bands, mapBand);
+}
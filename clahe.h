@@ -0,0 +1,51 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+// Contrast limited adaptive histogram equalization of an 8 bits single
+// channel image. The image is split in a grid of tiles, each tile is
+// equalized with its own clipped histogram and every pixel is mapped by the
+// bilinear blend of the four tiles around it.
+//
+// The histograms of the tiles only depend on the grid, so they are counted
+// once and kept for any clip limit.
+class Clahe
+{
+  public:
+    Clahe(cv::Mat const& image, int tilesX, int tilesY);
+
+    // A clip limit of n lets a bin of a tile hold n times the count of a
+    // flat histogram, the excess is spread over all the bins.
+    void apply(double clipLimit, cv::Mat& result) const;
+
+  private:
+    cv::Mat image;
+    int tilesX;
+    int tilesY;
+    std::vector<int> xEdges;
+    std::vector<int> yEdges;
+    std::vector<unsigned int> histograms;
+
+    void equalize(int tile, double clipLimit, uchar* lut) const;
+};
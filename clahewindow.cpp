@@ -0,0 +1,102 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clahewindow.h"
+#include "ui_clahewindow.h"
+
+#include "clahe.h"
+#include "image.h"
+
+ClaheWindow::ClaheWindow(Image* image,
+                         QWidget *parent) :
+  QMainWindow(parent),
+  ui(new Ui::ClaheWindow),
+  image(image),
+  clahe(0),
+  abort(true)
+{
+  ui->setupUi(this);
+
+  image->backup();
+
+  clahe = new Clahe(image->previous,
+                    ui->tilesSpinBox->value(),
+                    ui->tilesSpinBox->value());
+
+  connect(this,   SIGNAL(update()),
+          image,  SLOT(update()));
+
+  this->setAttribute(Qt::WA_DeleteOnClose);
+  this->setFixedSize(this->size());
+
+  this->show();
+
+  equalize();
+}
+
+ClaheWindow::~ClaheWindow()
+{
+  delete clahe;
+  delete ui;
+}
+
+void ClaheWindow::closeEvent(QCloseEvent *)
+{
+  if (abort)
+    image->undo();
+}
+
+void ClaheWindow::on_cancelPushButton_clicked()
+{
+  this->close();
+}
+
+void ClaheWindow::on_okPushButton_clicked()
+{
+  abort = false;
+
+  this->close();
+}
+
+// Only a new grid needs the tiles to be counted again
+void ClaheWindow::on_tilesSpinBox_valueChanged(int tiles)
+{
+  delete clahe;
+  clahe = new Clahe(image->previous, tiles, tiles);
+
+  equalize();
+}
+
+void ClaheWindow::on_clipLimitSlider_valueChanged(int)
+{
+  equalize();
+}
+
+void ClaheWindow::equalize()
+{
+  double clipLimit = ui->clipLimitSlider->value() / 10.0;
+
+  ui->clipLimitLabel->setText(QString::number(clipLimit, 'f', 1));
+
+  image->detach();
+
+  clahe->apply(clipLimit, image->current);
+
+  emit update();
+}
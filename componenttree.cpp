@@ -0,0 +1,169 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "componenttree.h"
+
+#include <opencv2/core/core.hpp>
+
+namespace {
+  int findRoot(std::vector<int>& zpar, int p)
+  {
+    int root = p;
+
+    while (zpar[root] != root)
+      root = zpar[root];
+
+    while (zpar[p] != root) {
+      int next = zpar[p];
+      zpar[p] = root;
+      p = next;
+    }
+
+    return root;
+  }
+
+  int areaBin(unsigned int area)
+  {
+    int bin = 0;
+
+    while (area >>= 1)
+      bin++;
+
+    return bin;
+  }
+}
+
+// Berger et al., "Effective component tree computation with application to
+// pattern recognition in astronomical imaging", with 8-connectivity.
+ComponentTree::ComponentTree(cv::Mat const& image) :
+  counts(thresholds, 0),
+  distribution(thresholds * areaBins, 0)
+{
+  int const rows = image.rows;
+  int const cols = image.cols;
+  int const n = rows * cols;
+
+  std::vector<uchar> level(n);
+  for (int i = 0; i < rows; i++)
+    for (int j = 0; j < cols; j++)
+      level[i * cols + j] = image.at<uchar>(i, j);
+
+  // Pixels sorted by decreasing level
+  std::vector<int> order(n);
+  {
+    int start[257] = {0};
+
+    for (int p = 0; p < n; p++)
+      start[255 - level[p] + 1]++;
+
+    for (int l = 0; l < 256; l++)
+      start[l + 1] += start[l];
+
+    for (int p = 0; p < n; p++)
+      order[start[255 - level[p]]++] = p;
+  }
+
+  std::vector<int> parent(n);
+  std::vector<int> zpar(n, -1);
+
+  for (int i = 0; i < n; i++) {
+    int p = order[i];
+    int y = p / cols;
+    int x = p % cols;
+
+    parent[p] = p;
+    zpar[p] = p;
+
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        if ((dy != 0 || dx != 0) &&
+            0 <= y + dy && y + dy < rows && 0 <= x + dx && x + dx < cols) {
+          int q = p + dy * cols + dx;
+
+          if (zpar[q] != -1) {
+            int r = findRoot(zpar, q);
+
+            if (r != p) {
+              parent[r] = p;
+              zpar[r] = p;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  zpar.clear();
+
+  // Point every pixel to the canonical pixel of its parent node
+  for (int i = n - 1; i >= 0; i--) {
+    int p = order[i];
+    int q = parent[p];
+
+    if (level[parent[q]] == level[q])
+      parent[p] = parent[q];
+  }
+
+  // Parents come after their children in order, so the areas accumulate
+  // bottom-up and a node's area is complete when it's reached. Canonical
+  // pixels are the tree nodes. The counts and area distributions are built
+  // through difference arrays.
+  std::vector<unsigned int> area(n, 1);
+
+  for (int i = 0; i < n; i++) {
+    int p = order[i];
+    int q = parent[p];
+
+    if (q != p)
+      area[q] += area[p];
+
+    if (q == p || level[q] != level[p]) {
+      // Particle for the thresholds [parent level, level), stored shifted by
+      // one so that the threshold -1 is the index 0.
+      int low = q == p ? 0 : level[q] + 1;
+      int high = level[p] + 1;
+      int bin = areaBin(area[p]);
+
+      counts[low]++;
+      counts[high]--;
+      distribution[low * areaBins + bin]++;
+      distribution[high * areaBins + bin]--;
+    }
+  }
+
+  for (int t = 1; t < thresholds; t++) {
+    counts[t] += counts[t - 1];
+
+    for (int b = 0; b < areaBins; b++)
+      distribution[t * areaBins + b] += distribution[(t - 1) * areaBins + b];
+  }
+}
+
+int ComponentTree::count(int threshold) const
+{
+  return counts[threshold + 1];
+}
+
+std::vector<int> ComponentTree::areaDistribution(int threshold) const
+{
+  std::vector<int>::const_iterator first =
+      distribution.begin() + (threshold + 1) * areaBins;
+
+  return std::vector<int>(first, first + areaBins);
+}
@@ -0,0 +1,52 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+
+namespace cv {
+  class Mat;
+}
+
+// Max-tree of an 8 bits image, built once to answer which 8-connected
+// particles appear when the image is thresholded at any level. A particle at
+// threshold t is a connected component of the pixels above t.
+class ComponentTree
+{
+  public:
+    // Particle areas are binned in powers of two: bin i counts the particles
+    // with an area in [2^i, 2^(i + 1)).
+    static int const areaBins = 32;
+
+    explicit ComponentTree(cv::Mat const& image);
+
+    // The threshold goes from -1 (every pixel) to 255 (no pixel).
+    int count(int threshold) const;
+    std::vector<int> areaDistribution(int threshold) const;
+
+  private:
+    // Every node of the tree is a particle for the thresholds from its
+    // parent level up to its own level - 1. Only the counts and the area
+    // distributions are kept, per threshold.
+    static int const thresholds = 257;
+
+    std::vector<int> counts;
+    std::vector<int> distribution;
+};
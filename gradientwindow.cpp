@@ -205,6 +205,8 @@ void GradientWindow::gradient()
 
   cv::normalize(tmp, tmp, 0, 1, cv::NORM_MINMAX);
 
+  image->detach();
+
   tmp.convertTo(image->current, CV_8U, 255.0);
 
   emit update();
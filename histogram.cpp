@@ -19,31 +19,44 @@
 
 #include "histogram.h"
 
-#include <opencv2/highgui/highgui.hpp>
-#include <opencv2/imgproc/imgproc.hpp>
+#include "histogramengine.h"
 
-Histogram::Histogram(cv::Mat const& image, int const numberOfBins)
+#include <opencv2/core/core.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  int const floatBaseBins = 65536;
+}
+
+Histogram::Histogram(cv::Mat const& image, int const numberOfBins) :
+  integer(image.depth() != CV_32F),
+  min(0),
+  max(256),
+  numberOfBins(numberOfBins),
+  logScale(false),
+  columns(0)
 {
-  cv::Mat histogram;
+  if (image.depth() != CV_8U && !image.empty()) {
+    cv::Mat channel = image;
 
-  std::vector<cv::Mat> images;
-  std::vector<int> channels;
-  std::vector<int> histSize;
-  std::vector<float> ranges;
+    if (image.channels() > 1)
+      cv::extractChannel(image, channel, 0);
 
-  images.push_back(image);
-  channels.push_back(0);
-  histSize.push_back(numberOfBins);
-  ranges.push_back(0);
-  ranges.push_back(256);
+    cv::minMaxLoc(channel, &min, &max);
 
-  cv::calcHist(images, channels, cv::Mat(), histogram, histSize, ranges);
+    if (integer)
+      max += 1;
+    else if (max <= min)
+      max = min + 1;
+    else
+      max = min + (max - min) * floatBaseBins / (floatBaseBins - 1);
+  }
 
-  QVector<QwtIntervalSample> samples(numberOfBins);
+  int baseBins = integer ? int(max - min) : floatBaseBins;
 
-  for (int i = 0; i < numberOfBins; i++)
-    samples[i] = QwtIntervalSample(histogram.at<float>(i),
-                                   QwtInterval(i, i + 1));
+  calculateHistogram(image, 0, baseBins, min, max, base);
 
   QColor color(Qt::blue);
 
@@ -52,7 +65,162 @@ Histogram::Histogram(cv::Mat const& image, int const numberOfBins)
   color.setAlpha(96);
   setBrush(QBrush(color));
 
-  setData(new QwtIntervalSeriesData(samples));
+  updateSamples();
+}
+
+Histogram::Histogram(std::vector<unsigned int> const& counts,
+                     int const numberOfBins) :
+  base(counts),
+  integer(true),
+  min(0),
+  max(256),
+  numberOfBins(numberOfBins),
+  logScale(false),
+  columns(0)
+{
+  QColor color(Qt::blue);
+
+  color.setAlpha(0);
+  setPen(QPen(color));
+  color.setAlpha(96);
+  setBrush(QBrush(color));
+
+  updateSamples();
+}
+
+double Histogram::minimum() const
+{
+  return min;
+}
+
+double Histogram::maximum() const
+{
+  return max;
+}
+
+int Histogram::bins() const
+{
+  return numberOfBins;
+}
+
+void Histogram::setBins(int bins)
+{
+  numberOfBins = bins;
+
+  updateSamples();
+}
+
+void Histogram::setLogScale(bool logScale)
+{
+  this->logScale = logScale;
+
+  updateSamples();
+}
+
+void Histogram::setCounts(std::vector<unsigned int> const& counts,
+                          double min,
+                          double max,
+                          bool exact)
+{
+  base = counts;
+  integer = exact;
+  this->min = min;
+  this->max = max;
+
+  updateSamples();
+}
+
+// Computed on the base histogram, with the values of inexact bins taken at
+// their centers.
+void Histogram::statistics(double& mean, double& deviation, double& median) const
+{
+  double const width = (max - min) / base.size();
+  double n = 0, sum = 0, squares = 0;
+
+  for (size_t i = 0; i < base.size(); i++) {
+    double value = integer ? min + i : min + (i + 0.5) * width;
+
+    n += base[i];
+    sum += base[i] * value;
+    squares += base[i] * value * value;
+  }
+
+  mean = n > 0 ? sum / n : 0;
+  deviation = n > 0 ? std::sqrt(std::max(0.0, squares / n - mean * mean)) : 0;
+  median = 0;
+
+  double acc = 0;
+
+  for (size_t i = 0; i < base.size(); i++) {
+    acc += base[i];
+
+    if (acc > n / 2) {
+      median = integer ? min + i : min + (i + 0.5) * width;
+      break;
+    }
+  }
+}
+
+void Histogram::setPlotWidth(int pixels)
+{
+  columns = pixels;
+
+  showSamples();
+}
+
+// An integer base bin holds a single value, so it is binned exactly as the
+// image would be. A float base bin is binned by its center.
+void Histogram::updateSamples()
+{
+  std::vector<double> counts(numberOfBins, 0);
+  double const baseWidth = (max - min) / base.size();
+  double const a = numberOfBins / (max - min);
+
+  for (size_t i = 0; i < base.size(); i++) {
+    double offset = integer ? i : (i + 0.5) * baseWidth;
+    int bin = std::min(int(std::floor(offset * a)), numberOfBins - 1);
+
+    counts[bin] += base[i];
+  }
+
+  heights.resize(numberOfBins);
+
+  for (int i = 0; i < numberOfBins; i++)
+    heights[i] = logScale ? std::log10(1 + counts[i]) : counts[i];
+
+  decimated.clear();
+
+  showSamples();
+}
+
+// Each bar covering several bins takes their highest count, so no peak is
+// lost. Bars are filled from zero, the lowest count would be hidden anyway.
+void Histogram::showSamples()
+{
+  int bars = numberOfBins;
+
+  if (columns > 0 && columns < numberOfBins)
+    bars = columns;
+
+  if (!decimated.contains(bars)) {
+    QVector<QwtIntervalSample> samples(bars);
+    double const width = (max - min) / numberOfBins;
+
+    for (int c = 0; c < bars; c++) {
+      int first = qint64(c) * numberOfBins / bars;
+      int last = qint64(c + 1) * numberOfBins / bars;
+      double height = 0;
+
+      for (int i = first; i < last; i++)
+        height = std::max(height, heights[i]);
+
+      samples[c] = QwtIntervalSample(height,
+                                     QwtInterval(min + first * width,
+                                                 min + last * width));
+    }
 
+    decimated.insert(bars, samples);
+  }
 
+  setData(new QwtIntervalSeriesData(decimated.value(bars)));
 }
@@ -21,12 +21,54 @@
 
 #include <qwt_plot_histogram.h>
 
+#include <QMap>
+
+#include <vector>
+
 namespace cv {
   class Mat;
 }
 
+// Histogram of the first channel of an image. 8 bits images span [0, 256),
+// 16 bits and float images the range of their data. The image is counted
+// once into a fine base histogram, one bin per value for integer images, and
+// every bin count is derived from it without looking at the image again.
 class Histogram : public QwtPlotHistogram
 {
   public:
     Histogram(cv::Mat const&, int const);
+    // From the counts of the 256 values of an 8 bits image
+    Histogram(std::vector<unsigned int> const&, int const);
+
+    double minimum() const;
+    double maximum() const;
+    int bins() const;
+
+    void setBins(int bins);
+    void setLogScale(bool logScale);
+    void setPlotWidth(int pixels);
+
+    // Replaces the base histogram. exact tells that every bin holds a
+    // single value.
+    void setCounts(std::vector<unsigned int> const& counts,
+                   double min,
+                   double max,
+                   bool exact);
+    void statistics(double& mean, double& deviation, double& median) const;
+
+  private:
+    std::vector<unsigned int> base;
+    bool integer;
+    double min;
+    double max;
+    int numberOfBins;
+    bool logScale;
+    // Bins are merged to one bar per pixel of the plot, the merged series
+    // are kept for every width they were asked for until the bins change.
+    int columns;
+    std::vector<double> heights;
+    QMap<int, QVector<QwtIntervalSample> > decimated;
+
+    void updateSamples();
+    void showSamples();
 };
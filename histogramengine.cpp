@@ -0,0 +1,192 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "histogramengine.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QVector>
+
+#include <cstring>
+
+namespace {
+  // Consecutive pixels often have the same value. Counting them in separate
+  // banks keeps an increment from waiting on the store of the previous one.
+  int const banks = 4;
+
+  struct Band {
+      cv::Mat const* image;
+      int channel;
+      int bins;
+      double min;
+      double max;
+      int first;
+      int last;
+      std::vector<unsigned int> counts;
+  };
+
+  // 8 and 16 bits values are counted exactly and binned afterwards
+  template<typename T>
+  void countValues(Band& band)
+  {
+    int const values = 1 << (8 * sizeof(T));
+    int const cn = band.image->channels();
+    int const cols = band.image->cols;
+
+    std::vector<unsigned int> bank(banks * values, 0);
+    unsigned int* c0 = &bank[0];
+    unsigned int* c1 = c0 + values;
+    unsigned int* c2 = c1 + values;
+    unsigned int* c3 = c2 + values;
+
+    for (int i = band.first; i < band.last; i++) {
+      T const* p = band.image->ptr<T>(i) + band.channel;
+      int j = 0;
+
+      if (sizeof(T) == 1 && cn == 1) {
+        // Four pixels per load
+        for (; j + 4 <= cols; j += 4) {
+          quint32 word;
+          std::memcpy(&word, p + j, 4);
+
+          c0[word & 0xff]++;
+          c1[(word >> 8) & 0xff]++;
+          c2[(word >> 16) & 0xff]++;
+          c3[word >> 24]++;
+        }
+      } else {
+        for (; j + 4 <= cols; j += 4) {
+          c0[p[j * cn]]++;
+          c1[p[(j + 1) * cn]]++;
+          c2[p[(j + 2) * cn]]++;
+          c3[p[(j + 3) * cn]]++;
+        }
+      }
+
+      for (; j < cols; j++)
+        c0[p[j * cn]]++;
+    }
+
+    band.counts.assign(values, 0);
+
+    for (int v = 0; v < values; v++)
+      band.counts[v] = c0[v] + c1[v] + c2[v] + c3[v];
+  }
+
+  void countFloats(Band& band)
+  {
+    int const cn = band.image->channels();
+    int const cols = band.image->cols;
+    int const bins = band.bins;
+    double const a = bins / (band.max - band.min);
+    double const b = -band.min * a;
+
+    std::vector<unsigned int> bank(banks * bins, 0);
+
+    for (int i = band.first; i < band.last; i++) {
+      float const* p = band.image->ptr<float>(i) + band.channel;
+
+      for (int j = 0; j < cols; j++) {
+        int bin = cvFloor(p[j * cn] * a + b);
+
+        // Also rejects NaN, whose bin is out of range
+        if (0 <= bin && bin < bins)
+          bank[(j & (banks - 1)) * bins + bin]++;
+      }
+    }
+
+    band.counts.assign(bins, 0);
+
+    for (int k = 0; k < banks; k++)
+      for (int bin = 0; bin < bins; bin++)
+        band.counts[bin] += bank[k * bins + bin];
+  }
+
+  void countBand(Band& band)
+  {
+    switch (band.image->depth()) {
+      case CV_8U:
+        countValues<quint8>(band);
+        break;
+      case CV_16U:
+        countValues<quint16>(band);
+        break;
+      case CV_32F:
+        countFloats(band);
+        break;
+    }
+  }
+}
+
+// The image is split in row bands counted by the global thread pool, the
+// band histograms are added up at the end.
+void calculateHistogram(cv::Mat const& image,
+                        int channel,
+                        int bins,
+                        double min,
+                        double max,
+                        std::vector<unsigned int>& counts)
+{
+  counts.assign(bins, 0);
+
+  if (image.empty() || bins <= 0 || !(min < max))
+    return;
+
+  int depth = image.depth();
+
+  if (depth != CV_8U && depth != CV_16U && depth != CV_32F)
+    return;
+
+  // Bands of at least 64 rows, so the bank setup doesn't dominate
+  int count = qBound(1, QThread::idealThreadCount(), image.rows / 64 + 1);
+  QVector<Band> bands(count);
+
+  for (int k = 0; k < count; k++) {
+    bands[k].image = &image;
+    bands[k].channel = channel;
+    bands[k].bins = bins;
+    bands[k].min = min;
+    bands[k].max = max;
+    bands[k].first = k * image.rows / count;
+    bands[k].last = (k + 1) * image.rows / count;
+  }
+
+  QtConcurrent::blockingMap(bands, countBand);
+
+  if (depth == CV_32F) {
+    for (int k = 0; k < count; k++)
+      for (int bin = 0; bin < bins; bin++)
+        counts[bin] += bands[k].counts[bin];
+  } else {
+    // Same bin mapping as cv::calcHist
+    double const a = bins / (max - min);
+    double const b = -min * a;
+    int const values = bands[0].counts.size();
+
+    for (int v = 0; v < values; v++) {
+      int bin = cvFloor(v * a + b);
+
+      if (0 <= bin && bin < bins)
+        for (int k = 0; k < count; k++)
+          counts[bin] += bands[k].counts[v];
+    }
+  }
+}
@@ -0,0 +1,36 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+
+namespace cv {
+  class Mat;
+}
+
+// Histogram of one channel of an 8 bits, 16 bits or float image, in bins of
+// the same width over [min, max). Values out of the range aren't counted, as
+// with cv::calcHist.
+void calculateHistogram(cv::Mat const& image,
+                        int channel,
+                        int bins,
+                        double min,
+                        double max,
+                        std::vector<unsigned int>& counts);
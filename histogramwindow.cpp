@@ -20,6 +20,8 @@
 #include "histogramwindow.h"
 #include "ui_histogramwindow.h"
 
+#include "regionhistogram.h"
+
 HistogramWindow::HistogramWindow(cv::Mat const& image, QWidget *parent) :
   QMainWindow(parent),
   ui(new Ui::HistogramWindow),
@@ -30,12 +32,17 @@ HistogramWindow::HistogramWindow(cv::Mat const& image, QWidget *parent) :
   histogram.attach(ui->histogramPlot);
 
   ui->histogramPlot->setAxisAutoScale(QwtPlot::xBottom, false);
-  ui->histogramPlot->setAxisScale(QwtPlot::xBottom, 0, 256);
+  ui->histogramPlot->setAxisScale(QwtPlot::xBottom,
+                                  histogram.minimum(),
+                                  histogram.maximum());
 
   ui->histogramPlot->enableAxis(QwtPlot::xBottom, false);
   ui->histogramPlot->enableAxis(QwtPlot::yLeft, false);
 
+  showStatistics();
+
   ui->histogramPlot->setFixedSize(480, 200);
+  histogram.setPlotWidth(480);
   this->adjustSize();
 
   this->setAttribute(Qt::WA_DeleteOnClose);
@@ -48,3 +55,50 @@ HistogramWindow::~HistogramWindow()
 {
   delete ui;
 }
+
+// Both only rebin the histogram counted when the window was opened
+void HistogramWindow::on_binsSpinBox_valueChanged(int bins)
+{
+  histogram.setBins(bins);
+
+  ui->histogramPlot->replot();
+}
+
+void HistogramWindow::on_logCheckBox_toggled(bool checked)
+{
+  histogram.setLogScale(checked);
+
+  ui->histogramPlot->replot();
+}
+
+// The histogram of a part of the image, it replaces the one shown
+void HistogramWindow::showRegion(RegionHistogram const& region,
+                                 QRect const& rect)
+{
+  std::vector<unsigned int> counts;
+
+  region.histogram(rect, counts);
+
+  histogram.setCounts(counts,
+                      region.minimum(),
+                      region.maximum(),
+                      region.exact());
+
+  ui->histogramPlot->setAxisScale(QwtPlot::xBottom,
+                                  histogram.minimum(),
+                                  histogram.maximum());
+  ui->histogramPlot->replot();
+
+  showStatistics();
+}
+
+void HistogramWindow::showStatistics()
+{
+  double mean, deviation, median;
+
+  histogram.statistics(mean, deviation, median);
+
+  ui->statisticsLabel->setText("Mean: " + QString::number(mean) +
+                               "\tStd: " + QString::number(deviation) +
+                               "\tMedian: " + QString::number(median));
+}
@@ -23,6 +23,10 @@
 
 #include "histogram.h"
 
+class RegionHistogram;
+
+class QRect;
+
 namespace cv {
   class Mat;
 }
@@ -38,8 +42,16 @@ class HistogramWindow : public QMainWindow
   public:
     explicit HistogramWindow(cv::Mat const&, QWidget *parent = 0);
     ~HistogramWindow();
+
+    void showRegion(RegionHistogram const& region, QRect const& rect);
+
+  private slots:
+    void on_binsSpinBox_valueChanged(int);
+    void on_logCheckBox_toggled(bool);
     
   private:
     Ui::HistogramWindow *ui;
     Histogram histogram;
+
+    void showStatistics();
 };
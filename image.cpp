@@ -20,19 +20,37 @@
 #include "image.h"
 #include "ui_image.h"
 
+#include "histogramengine.h"
+#include "lookuptable.h"
+#include "pointwise.h"
 #include "mat2qimage.h"
+#include "regionhistogram.h"
 #include "textlistwindow.h"
 
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include <QScrollBar>
-#include <QPainter>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+QList<Image*> Image::recentlyViewed;
+
+namespace {
+  // The buffers are shared between images instead of copied, one that is
+  // also held elsewhere gets its own copy before being written.
+  bool shared(cv::Mat const& image)
+  {
+    return image.refcount != 0 && *image.refcount > 1;
+  }
+}
 
 Image::Image(QString pathToImage, QWidget *parent) :
   QWidget(parent),
   ui(new Ui::Image),
-  first(cv::imread(pathToImage.toStdString()))
+  first(cv::imread(pathToImage.toStdString())),
+  channel(-1)
 {
   initialize();
 }
@@ -40,7 +58,17 @@ Image::Image(QString pathToImage, QWidget *parent) :
 Image::Image(cv::Mat const& image, QWidget *parent) :
   QWidget(parent),
   ui(new Ui::Image),
-  first(image)
+  first(image),
+  channel(-1)
+{
+  initialize();
+}
+
+Image::Image(cv::Mat const& image, int channel, QWidget *parent) :
+  QWidget(parent),
+  ui(new Ui::Image),
+  source(image),
+  channel(channel)
 {
   initialize();
 }
@@ -52,9 +80,19 @@ void Image::initialize()
   distances = 0;
   areas = 0;
 
-  first.copyTo(current);
+  generation = 1;
+  statisticsGeneration = 0;
+  pixmapGeneration = 0;
+  regionGeneration = 0;
+  region = 0;
+  histogramGeneration = 0;
+  pixmapFit = false;
+
+  current = first;
 
   color = QColor(Qt::red);
+  overlay.color = color;
+  ui->imageLabel->setRubberBandColor(color);
 
   mousePressed = false;
   selectionMode = None;
@@ -76,6 +114,15 @@ void Image::initialize()
   connect(ui->imageLabel, SIGNAL(mouseRelease(QPoint)),
           this,           SLOT(mouseRelease(QPoint)));
 
+  smoothTimer.setSingleShot(true);
+  smoothTimer.setInterval(250);
+
+  connect(&smoothTimer,   SIGNAL(timeout()),
+          this,           SLOT(display()));
+
+  connect(&minMaxWatcher, SIGNAL(finished()),
+          this,           SLOT(showMinMax()));
+
   connect(ui->imageLabel, SIGNAL(resized()),
           this,           SLOT(rescale()));
 
@@ -88,6 +135,9 @@ void Image::initialize()
 
 Image::~Image()
 {
+  recentlyViewed.removeOne(this);
+
+  delete region;
   delete ui;
   distances->close();
   areas->close();
@@ -98,58 +148,195 @@ Image::~Image()
   first.release();
 }
 
+// A pointwise operation. The image before it becomes the backup without
+// being copied, and the histogram goes through the table instead of being
+// counted again.
+void Image::apply(LookupTable const& lut)
+{
+  materialize();
+
+  bool keepHistogram = current.depth() == CV_8U &&
+                       histogramGeneration == generation;
+
+  previous = current;
+  current = cv::Mat();
+
+  lut.apply(previous, current);
+
+  if (keepHistogram)
+    lut.apply(histogramCounts);
+
+  update();
+
+  if (keepHistogram)
+    histogramGeneration = generation;
+}
+
+// Operations write current in place after a backup, so that is where a
+// shared buffer is left to its other holders.
 void Image::backup()
 {
-  current.copyTo(previous);
+  materialize();
+
+  if (shared(current)) {
+    previous = current;
+    current = current.clone();
+  } else {
+    if (shared(previous))
+      previous.release();
+
+    current.copyTo(previous);
+  }
+}
+
+// The statistics of the last update may still be reading current. The
+// callers overwrite all of it, so its contents aren't copied: the next
+// write allocates a new buffer.
+void Image::detach()
+{
+  if (shared(current))
+    current.release();
 }
 
-void Image::HSV(std::vector<cv::Mat>& hsv) const
+void Image::HSV(cv::Mat& hsv) const
 {
-  cv::Mat tmp;
+  cv::cvtColor(current, hsv, CV_BGR2HSV);
+}
+
+// As apply(), with the kernel that works for any depth
+void Image::invert()
+{
+  materialize();
+
+  bool keepHistogram = current.depth() == CV_8U &&
+                       histogramGeneration == generation;
+
+  previous = current;
+  current = cv::Mat();
 
-  cv::cvtColor(current, tmp, CV_BGR2HSV);
+  invertImage(previous, current);
 
-  cv::split(tmp, hsv);
+  if (keepHistogram)
+    std::reverse(histogramCounts.begin(), histogramCounts.end());
+
+  update();
+
+  if (keepHistogram)
+    histogramGeneration = generation;
 }
 
 void Image::revert()
 {
-  first.copyTo(current);
+  materialize();
+
+  current = first;
   previous.release();
 
   update();
 }
 
-void Image::RGB(std::vector<cv::Mat>& rgb) const
+cv::Mat const& Image::channelSource(int& channel) const
+{
+  if (source.data != 0) {
+    channel = this->channel;
+    return source;
+  }
+
+  channel = -1;
+  return current;
+}
+
+void Image::materialize()
+{
+  if (source.data != 0) {
+    cv::extractChannel(source, first, channel);
+    source.release();
+
+    current = first;
+  }
+}
+
+// Built on first use for each generation of the image
+RegionHistogram const& Image::regionHistogram()
+{
+  materialize();
+
+  if (region == 0 || regionGeneration != generation) {
+    delete region;
+
+    region = new RegionHistogram(current);
+    regionGeneration = generation;
+  }
+
+  return *region;
+}
+
+// Counts of the first channel over [0, 256), built once per generation.
+// apply() and invert() carry them over to the next one. Every operation
+// writes the whole image, so there are no region edits to update the counts
+// by difference; any other change counts them again.
+std::vector<unsigned int> const& Image::histogram()
 {
-  cv::Mat tmp;
+  materialize();
 
-  cv::cvtColor(current, tmp, CV_BGR2RGB);
+  if (histogramGeneration != generation) {
+    calculateHistogram(current, 0, 256, 0, 256, histogramCounts);
+
+    histogramGeneration = generation;
+  }
 
-  cv::split(tmp, rgb);
+  return histogramCounts;
 }
 
 void Image::undo()
 {
   if (previous.data != 0) {
-    previous.copyTo(current);
+    current = previous;
     update();
   }
 }
 
+// The pixmap is only converted again when the image or the way it is shown
+// changed since the last time.
 void Image::display()
 {
-  pixmap = QPixmap::fromImage(Mat2QImage(current));
+  materialize();
+
+  bool fit = ui->fitToScreenCheckBox->isChecked();
+
+  if (pixmap.isNull() ||
+      pixmapGeneration != generation ||
+      pixmapFit != fit ||
+      (fit && pixmapSize != ui->imageLabel->size())) {
+    if (fit) {
+      // Area averaging on the image, so only what is shown gets converted
+      QSize size = QSize(current.cols, current.rows)
+                   .scaled(ui->imageLabel->size(), Qt::KeepAspectRatio);
+      cv::Mat scaled;
+
+      if (!size.isEmpty())
+        cv::resize(current,
+                   scaled,
+                   cv::Size(size.width(), size.height()),
+                   0,
+                   0,
+                   cv::INTER_AREA);
+
+      pixmap = QPixmap::fromImage(Mat2QImage(scaled));
+    } else {
+      pixmap = QPixmap::fromImage(Mat2QImage(current));
+    }
 
-  if (ui->fitToScreenCheckBox->isChecked())
-    pixmap = pixmap.scaled(ui->imageLabel->size(), Qt::KeepAspectRatio);
+    pixmapGeneration = generation;
+    pixmapFit = fit;
+    pixmapSize = ui->imageLabel->size();
+  }
 
-  loadOverlay();
+  touch();
 
-  if (ui->withOverlayCheckBox->isChecked())
-    ui->imageLabel->setPixmap(overlayedPixmap);
-  else
-    ui->imageLabel->setPixmap(pixmap);
+  ui->imageLabel->setPixmap(pixmap);
+
+  loadOverlay();
 }
 
 void Image::pixelInfo(QPoint p) const
@@ -194,7 +381,8 @@ void Image::mouseDoubleClick(QPoint p)
       } else {
         emit rectangleSelected(QRect());
       }
-      overlay.rect.pop_back();
+      overlay.removeLastRect();
+      ui->imageLabel->update();
       break;
   }
 
@@ -212,45 +400,21 @@ void Image::mouseMove(QPoint p)
     if (mousePressed) {
       p2 = p;
 
-      tempPixmap = overlayedPixmap;
-      color.setAlpha(128);
-
-      QPainter painter(&tempPixmap);
-      painter.setPen(color);
-
       switch (selectionMode) {
         case Rectangle:
-        {
-          QRect rect;
-
-          if (p1.x() < p2.x() || p1.y() < p2.y())
-            rect = QRect(p1 * pixmap.width() / current.cols,
-                         p2 * pixmap.height() / current.rows);
-          else
-            rect = QRect(p2 * pixmap.width() / current.cols,
-                         p1 * pixmap.height() / current.rows);
-
-          painter.drawRect(rect);
-          color.setAlpha(64);
-          painter.fillRect(rect, color);
+          ui->imageLabel->setRubberBand(ImageLabel::RectangleBand, p1, p2);
+
+          emit selectionChanged(QRect(p1, p2).normalized());
           break;
-        }
 
         case Distance:
         case Line:
-        {
-          QLine line(p1 * pixmap.width() / current.cols,
-                     p2 * pixmap.height() / current.rows);
-
-          painter.drawLine(line);
+          ui->imageLabel->setRubberBand(ImageLabel::LineBand, p1, p2);
           break;
-        }
 
         case None:
           break;
       }
-
-      ui->imageLabel->setPixmap(tempPixmap);
     }
   }
 }
@@ -267,6 +431,16 @@ void Image::mousePress(QPoint p)
 
     p1 = p;
     p2 = QPoint(-1, -1);
+  } else if (areas) {
+    remapPoint(p);
+
+    int particle = overlay.particleAt(p);
+
+    overlay.highlightParticle(particle);
+    ui->imageLabel->update();
+
+    if (particle > 0)
+      areas->select(particle - 1);
   }
 }
 
@@ -279,15 +453,13 @@ void Image::mouseRelease(QPoint p)
 
     p2 = p;
 
-    overlayedPixmap = tempPixmap;
-
     if (p1.x() >= 0 && p1.y() >= 0 && (p1.x() != p2.x() || p1.y() != p2.y()))
       switch (selectionMode) {
         case None:
           break;
 
         case Line:
-          overlay.line.append(QLine(p1, p2));
+          overlay.addLine(QLine(p1, p2));
           emit lineSelected(QLine(p1, p2));
           break;
 
@@ -300,20 +472,10 @@ void Image::mouseRelease(QPoint p)
           text.p = (p1 + p2) / 2;
           text.s = QString::number(N);
 
-          overlay.line.append(QLine(p1, p2));
-          overlay.text.append(text);
+          overlay.addLine(QLine(p1, p2));
+          overlay.addText(text);
 
-          QPainter p(&overlayedPixmap);
-          color.setAlpha(128);
-          p.setPen(QPen(color));
-          p.drawText((text.p * pixmap.width()) / current.cols,
-                     text.s);
-
-          ui->imageLabel->setPixmap(overlayedPixmap);
-          tempPixmap = overlayedPixmap;
-          distances->append(QString::number(N) + '\t' +
-                            QString::number(distance) + '\t' +
-                            unit);
+          distances->append(QVector<double>() << N << distance);
           break;
         }
 
@@ -322,13 +484,17 @@ void Image::mouseRelease(QPoint p)
 
           if (p1.x() < p2.x() || p1.y() < p2.y()) {
             rect = QRect(p1, p2);
-            overlay.rect.append(QRect(p1, p2));
+            overlay.addRect(QRect(p1, p2));
           } else {
             rect = QRect(p2, p1);
-            overlay.rect.append(QRect(p2, p1));
+            overlay.addRect(QRect(p2, p1));
           }
           break;
       }
+
+    // The rubber band is replaced by the overlay
+    ui->imageLabel->clearRubberBand();
+    ui->imageLabel->updateImageRect(QRect(p1, p2).normalized());
   }
 }
 
@@ -342,18 +508,31 @@ void Image::on_fitToScreenCheckBox_toggled(bool checked)
     display();
 }
 
+// While the label is being resized, the last pixmap is only stretched. The
+// image is scaled properly by display() once the resizing stops.
 void Image::rescale()
 {
   if (ui->fitToScreenCheckBox->isChecked()) {
+    QPixmap const* shown = ui->imageLabel->pixmap();
+
     if (ui->scrollArea->horizontalScrollBar()->maximum() == 0 &&
         ui->scrollArea->verticalScrollBar()->maximum() == 0) {
-      if (pixmap.width() != ui->imageLabel->width() &&
-          pixmap.height() != ui->imageLabel->height()) {
-        display();
+      if (shown == 0 ||
+          (shown->width() != ui->imageLabel->width() &&
+           shown->height() != ui->imageLabel->height())) {
+        if (pixmap.isNull()) {
+          display();
+        } else {
+          ui->imageLabel->setPixmap(pixmap.scaled(ui->imageLabel->size(),
+                                                  Qt::KeepAspectRatio,
+                                                  Qt::FastTransformation));
+          loadOverlay();
+
+          smoothTimer.start();
+        }
       }
-    } else if (pixmap.height() != 0 && pixmap.width() != 0) {
+    } else if (shown != 0 && !shown->isNull()) {
       ui->imageLabel->clear();
-      pixmap = QPixmap();
     }
   }
 }
@@ -374,34 +553,81 @@ void Image::setSelectionMode(SelectionMode mode)
         clearOverlay();
 
         distances = new TextListWindow("Distances",
-                                       "N\tLength\tUnit",
+                                       QStringList() << "N" << "Length",
+                                       QStringList() << "" << unit,
                                        this);
       }
 
       connect(distances,  SIGNAL(destroyed()),
               this,       SLOT(detachDistancesWindows()));
     case Line:
-      overlayedPixmap = pixmap;
-      tempPixmap = pixmap;
       emit status("Drag-draw a line. Double-click to exit.");
       break;
 
     case Rectangle:
       clearOverlay();
-      overlayedPixmap = pixmap;
-      tempPixmap = pixmap;
       emit status("Drag-select an area.");
       break;
   }
 }
 
+void Image::touch()
+{
+  recentlyViewed.removeOne(this);
+  recentlyViewed.prepend(this);
+
+  qint64 bytes = 0;
+
+  for (int i = 0; i < recentlyViewed.size(); i++) {
+    QPixmap const& p = recentlyViewed.at(i)->pixmap;
+
+    bytes += qint64(p.width()) * p.height() * p.depth() / 8;
+  }
+
+  for (int i = recentlyViewed.size() - 1; i > 0 && bytes > pixmapBudget; i--) {
+    QPixmap const& p = recentlyViewed.at(i)->pixmap;
+
+    bytes -= qint64(p.width()) * p.height() * p.depth() / 8;
+
+    recentlyViewed.at(i)->evict();
+  }
+}
+
+// Drops the rendered pixmap, the next display() converts the image again.
+void Image::evict()
+{
+  pixmap = QPixmap();
+  ui->imageLabel->clear();
+}
+
+// Shows the image again, e.g. when its tab is selected. Nothing is computed
+// if the image didn't change since it was last shown.
+void Image::refresh()
+{
+  showStatistics();
+
+  display();
+}
+
 void Image::update()
 {
-  double min, max;
-  cv::minMaxLoc(current, &min, &max);
+  generation++;
 
-  ui->minimumLabel->setText(QString::number(min));
-  ui->maximumLabel->setText(QString::number(max));
+  showStatistics();
+
+  clearOverlay();
+
+  display();
+}
+
+void Image::showStatistics()
+{
+  materialize();
+
+  if (statisticsGeneration == generation)
+    return;
+
+  statisticsGeneration = generation;
 
   ui->heightLabel->setText(QString::number(current.rows));
   ui->widthLabel->setText(QString::number(current.cols));
@@ -424,16 +650,42 @@ void Image::update()
       break;
   }
 
-  clearOverlay();
+  ui->minimumLabel->setText("...");
+  ui->maximumLabel->setText("...");
 
-  display();
+  // While the previews update the image, a single search runs at a time and
+  // the latest generation is searched when it's done.
+  if (!minMaxWatcher.isRunning())
+    minMaxWatcher.setFuture(QtConcurrent::run(minMax, current, generation));
+}
+
+// The image is shared, not copied, with the search; writers detach from it
+// instead of overwriting it. A result of an old generation is dropped.
+Image::Range Image::minMax(cv::Mat image, quint64 generation)
+{
+  Range range;
+
+  cv::minMaxLoc(image, &range.min, &range.max);
+  range.generation = generation;
+
+  return range;
+}
+
+void Image::showMinMax()
+{
+  Range range = minMaxWatcher.result();
+
+  if (range.generation == generation) {
+    ui->minimumLabel->setText(QString::number(range.min));
+    ui->maximumLabel->setText(QString::number(range.max));
+  } else if (statisticsGeneration == generation) {
+    minMaxWatcher.setFuture(QtConcurrent::run(minMax, current, generation));
+  }
 }
 
 void Image::clearOverlay()
 {
-  overlay.line.clear();
-  overlay.text.clear();
-  overlay.rect.clear();
+  overlay.clear();
 
   if (distances)
     distances->close();
@@ -442,45 +694,22 @@ void Image::clearOverlay()
     areas->close();
 
   ui->imageLabel->setPixmap(pixmap);
-  overlayedPixmap = pixmap;
+  loadOverlay();
 }
 
+// The label draws the overlay over the pixmap, culled to what is visible.
 void Image::loadOverlay()
 {
-  overlayedPixmap = pixmap;
-  QPainter p(&overlayedPixmap);
+  QPixmap const* shown = ui->imageLabel->pixmap();
+  qreal zoom = 1;
 
-  color.setAlpha(128);
-  p.setPen(color);
-  color.setAlpha(64);
-  for (int i = 0; i < overlay.line.size(); i++) {
-    QPoint p1 = overlay.line.at(i).p1();
-    QPoint p2 = overlay.line.at(i).p2();
+  if (shown != 0 && current.cols != 0)
+    zoom = qreal(shown->width()) / current.cols;
 
-    p1 = p1 * pixmap.width() / current.cols;
-    p2 = p2 * pixmap.width() / current.cols;
-
-    p.drawLine(QLine(p1, p2));
-  }
-
-  for (int i = 0; i < overlay.text.size(); i++) {
-    QPoint p1 = overlay.text.at(i).p;
-
-    p1 = p1 * pixmap.width() / current.cols;
-
-    p.drawText(p1, overlay.text.at(i).s);
-  }
-
-  for (int i = 0; i < overlay.rect.size(); i++) {
-    QPoint p1 = overlay.rect.at(i).topLeft();
-    QPoint p2 = overlay.rect.at(i).bottomRight();
-
-    p1 = p1 * pixmap.width() / current.cols;
-    p2 = p2 * pixmap.width() / current.cols;
-
-    p.drawRect(QRect(p1, p2));
-    p.fillRect(QRect(p1, p2), color);
-  }
+  if (ui->withOverlayCheckBox->isChecked())
+    ui->imageLabel->setOverlay(&overlay, zoom);
+  else
+    ui->imageLabel->setOverlay(0, zoom);
 }
 
 void Image::detachAreasWindows()
@@ -542,46 +771,60 @@ void Image::remapPoint(QPoint &p) const
   p.setY(y);
 }
 
-void Image::overlayAreas(std::vector<cv::ConnectedComponentStats> const &stats)
+void Image::overlayAreas(std::vector<cv::ConnectedComponentStats> const &stats,
+                         std::vector<cv::ConnectedComponentShape> const &shapes)
 {
   if (areas == 0) {
     ui->withOverlayCheckBox->setChecked(true);
 
     areas = new TextListWindow("Areas",
-                               "N\tArea\tUnit",
+                               QStringList() << "N" << "Area" << "Perimeter"
+                                             << "Circularity" << "Feret"
+                                             << "MinFeret" << "Angle"
+                                             << "Eccentricity" << "Convex",
+                               // Areas are in the square of the unit
+                               QStringList() << "" << unit + "^2" << unit
+                                             << "" << unit << unit << "deg"
+                                             << "" << unit + "^2",
                                this);
 
+    // All the rows go to the table at once
+    QVector<double> values;
+    values.reserve(9 * (stats.size() - 1));
+
     for (size_t i = 1; i < stats.size(); i++) {
       cv::ConnectedComponentStats stat = stats.at(i);
-
-      areas->append(QString::number(i) + "\t" +
-                    QString::number(stat.area * scale * scale) + "\t" +
-                    unit + "^2");
+      cv::ConnectedComponentShape shape = shapes.at(i);
+
+      values << i
+             << stat.area * scale * scale
+             << shape.perimeter * scale
+             << shape.circularity
+             << shape.feret_max * scale
+             << shape.feret_min * scale
+             << -shape.orientation * 180 / CV_PI
+             << shape.eccentricity
+             << shape.convex_area * scale * scale;
 
       Text text;
       text.p = QPoint(stat.centroid_x, stat.centroid_y);
       text.s = QString::number(i);
 
-      overlay.text.append(text);
-
-      QPainter p(&overlayedPixmap);
-      color.setAlpha(128);
-      p.setPen(QPen(color));
-      p.drawText((text.p * pixmap.width()) / current.cols,
-                 text.s);
+      overlay.addParticle(QRect(QPoint(stat.lower_x, stat.lower_y),
+                                QPoint(stat.upper_x, stat.upper_y)),
+                          text);
     }
 
+    areas->append(values);
+
     connect(areas,  SIGNAL(destroyed()),
             this,   SLOT(detachAreasWindows()));
 
-    ui->imageLabel->setPixmap(overlayedPixmap);
+    loadOverlay();
   }
 }
 
-void Image::on_withOverlayCheckBox_toggled(bool checked)
+void Image::on_withOverlayCheckBox_toggled(bool)
 {
-  if (checked)
-    ui->imageLabel->setPixmap(overlayedPixmap);
-  else
-    ui->imageLabel->setPixmap(pixmap);
+  loadOverlay();
 }
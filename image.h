@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <QFutureWatcher>
+#include <QList>
 #include <QWidget>
 #include <QTimer>
 
@@ -26,17 +28,16 @@
 
 #include <opencv_future/imgproc/connectedcomponents.hpp>
 
+#include "overlay.h"
+
+class LookupTable;
+class RegionHistogram;
 class TextListWindow;
 
 namespace Ui {
   class Image;
 }
 
-struct Text {
-    QPoint p;
-    QString s;
-};
-
 class Image : public QWidget
 {
     Q_OBJECT
@@ -48,8 +49,13 @@ class Image : public QWidget
 
     explicit Image(QString pathToImage, QWidget *parent = 0);
     explicit Image(cv::Mat const& image, QWidget *parent = 0);
+    explicit Image(cv::Mat const& image, int channel, QWidget *parent = 0);
     ~Image();
 
+    // The buffer of current may be shared with other images and with the
+    // background statistics, so it's never written in place without a call
+    // to backup() first. The previews, which write all of it again with
+    // every change of their parameters, call detach() before each write.
     cv::Mat current;
     cv::Mat previous;
     float scale;
@@ -57,16 +63,26 @@ class Image : public QWidget
     TextListWindow *areas;
     TextListWindow *distances;
 
+    void apply(LookupTable const& lut);
     void backup();
-    void HSV(std::vector<cv::Mat>& hsv) const;
+    void detach();
+    void HSV(cv::Mat& hsv) const;
+    void invert();
     void revert();
-    void RGB(std::vector<cv::Mat>& rgb) const;
     void undo();
 
+    RegionHistogram const& regionHistogram();
+    std::vector<unsigned int> const& histogram();
+
+    // The image a channel view that isn't extracted yet reads from, and its
+    // channel. Other images give current and -1.
+    cv::Mat const& channelSource(int& channel) const;
+
   signals:
     void exitSelectionMode();
     void lineSelected(QLine const& line, QPoint center = QPoint());
     void rectangleSelected(QRect const& rect);
+    void selectionChanged(QRect const& rect);
     void status(QString const& msg);
 
   public slots:
@@ -79,32 +95,65 @@ class Image : public QWidget
     void on_fitToScreenCheckBox_toggled(bool checked);
     void rescale();
     void setSelectionMode(SelectionMode mode = None);
+    void refresh();
     void update();
 
     void clearOverlay();
     void loadOverlay();
     void detachAreasWindows();
     void detachDistancesWindows();
-    void overlayAreas(std::vector<cv::ConnectedComponentStats> const &stats);
+    void overlayAreas(std::vector<cv::ConnectedComponentStats> const &stats,
+                      std::vector<cv::ConnectedComponentShape> const &shapes);
 
   private slots:
     void on_withOverlayCheckBox_toggled(bool checked);
+    void showMinMax();
 
   private:
+    struct Range {
+        double min;
+        double max;
+        quint64 generation;
+    };
+
     Ui::Image *ui;
     cv::Mat first;
-    QPixmap pixmap, tempPixmap, overlayedPixmap;
+    // A channel view only holds the image it was taken from, the channel is
+    // extracted when the view is first shown or edited.
+    cv::Mat source;
+    int channel;
+    QPixmap pixmap;
+    // current changes with every update(), what was computed from it is kept
+    // along with the generation it belongs to.
+    quint64 generation;
+    quint64 statisticsGeneration;
+    quint64 pixmapGeneration;
+    quint64 regionGeneration;
+    RegionHistogram *region;
+    quint64 histogramGeneration;
+    std::vector<unsigned int> histogramCounts;
+    bool pixmapFit;
+    QSize pixmapSize;
+    QFutureWatcher<Range> minMaxWatcher;
+    QTimer smoothTimer;
+
+    // The pixmaps of the tabs that aren't shown are kept while they fit in
+    // the budget, the least recently viewed are dropped first.
+    static qint64 const pixmapBudget = 256 * 1024 * 1024;
+    static QList<Image*> recentlyViewed;
     QPoint p1, p2;
     QRect rect;
     QColor color;
     bool mousePressed;
     SelectionMode selectionMode;
-    struct {
-        QVector<QLine> line;
-        QVector<Text> text;
-        QVector<QRect> rect;
-    } overlay;
+    Overlay overlay;
 
     void remapPoint(QPoint &p) const;
     void initialize();
+    void materialize();
+    void showStatistics();
+    void touch();
+    void evict();
+
+    static Range minMax(cv::Mat image, quint64 generation);
 };
@@ -19,34 +19,183 @@
 
 #include "imagelabel.h"
 
+#include "overlay.h"
+
 #include <QMouseEvent>
+#include <QPainter>
+#include <QStyle>
 
 ImageLabel::ImageLabel(QWidget *parent) :
-  QLabel(parent)
+  QLabel(parent),
+  overlay(0),
+  zoom(1),
+  band(NoBand),
+  bandColor(Qt::red),
+  hoverPending(false)
 {
   this->setMouseTracking(true);
+
+  // About one display frame
+  hoverTimer.setSingleShot(true);
+  hoverTimer.setInterval(16);
+
+  connect(&hoverTimer,  SIGNAL(timeout()),
+          this,         SLOT(flushHover()));
+}
+
+// The overlay isn't owned, a null overlay hides it.
+void ImageLabel::setOverlay(Overlay const* overlay, qreal zoom)
+{
+  this->overlay = overlay;
+  this->zoom = zoom;
+
+  update();
+}
+
+// The rubber band is given in image coordinates. Only the area it leaves and
+// the area it covers are repainted, the pixmap is never copied.
+void ImageLabel::setRubberBand(RubberBand shape,
+                               QPoint const& p1,
+                               QPoint const& p2)
+{
+  QRect dirty = bandRect();
+
+  band = shape;
+  bandP1 = p1;
+  bandP2 = p2;
+
+  update(dirty | bandRect());
+}
+
+void ImageLabel::setRubberBandColor(QColor const& color)
+{
+  bandColor = color;
+}
+
+void ImageLabel::clearRubberBand()
+{
+  setRubberBand(NoBand, QPoint(), QPoint());
+}
+
+// Repaints an area of the image, with some room for the overlay labels.
+void ImageLabel::updateImageRect(QRect const& rect)
+{
+  QPoint origin = target().topLeft();
+  int margin = 2 * fontMetrics().height() + fontMetrics().width("00000");
+
+  update(QRectF(origin + QPointF(rect.topLeft()) * zoom,
+                origin + QPointF(rect.bottomRight() + QPoint(1, 1)) * zoom)
+         .toAlignedRect()
+         .adjusted(-margin, -margin, margin, margin));
+}
+
+QRect ImageLabel::target() const
+{
+  if (!pixmap())
+    return QRect();
+
+  return QStyle::alignedRect(layoutDirection(),
+                             QStyle::visualAlignment(layoutDirection(),
+                                                     alignment()),
+                             pixmap()->size(),
+                             contentsRect());
+}
+
+// Widget area covered by the rubber band, pen included
+QRect ImageLabel::bandRect() const
+{
+  if (band == NoBand)
+    return QRect();
+
+  QPoint origin = target().topLeft();
+
+  return QRectF(origin + QPointF(bandP1) * zoom,
+                origin + QPointF(bandP2) * zoom)
+         .normalized()
+         .toAlignedRect()
+         .adjusted(-2, -2, 2, 2);
+}
+
+// Mouse moves are coalesced to one mouseHover per frame, with the last
+// position. A pending move is sent before any other mouse event so they keep
+// their order.
+void ImageLabel::flushHover()
+{
+  hoverTimer.stop();
+
+  if (hoverPending) {
+    hoverPending = false;
+
+    emit mouseHover(hoverPos);
+  }
 }
 
 void ImageLabel::mouseDoubleClickEvent(QMouseEvent *ev)
 {
+  flushHover();
+
   emit mouseDoubleClick(ev->pos());
 }
 
 void ImageLabel::mouseMoveEvent(QMouseEvent *ev)
 {
-  emit mouseHover(ev->pos());
+  hoverPos = ev->pos();
+  hoverPending = true;
+
+  if (!hoverTimer.isActive())
+    hoverTimer.start();
 }
 
 void ImageLabel::mousePressEvent(QMouseEvent *ev)
 {
+  flushHover();
+
   emit mousePress(ev->pos());
 }
 
 void ImageLabel::mouseReleaseEvent(QMouseEvent *ev)
 {
+  flushHover();
+
   emit mouseRelease(ev->pos());
 }
 
+// The overlay and the rubber band are layers drawn over the pixmap instead of
+// into a copy of it, and only where the label is exposed, which inside a
+// scroll area is the viewport.
+void ImageLabel::paintEvent(QPaintEvent *ev)
+{
+  QLabel::paintEvent(ev);
+
+  if (!pixmap() || pixmap()->isNull())
+    return;
+
+  QRect area = target();
+  QPainter painter(this);
+
+  if (overlay)
+    overlay->paint(painter, ev->rect() & area, area.topLeft(), zoom);
+
+  if (band != NoBand) {
+    QPointF p1 = area.topLeft() + QPointF(bandP1) * zoom;
+    QPointF p2 = area.topLeft() + QPointF(bandP2) * zoom;
+    QColor color(bandColor);
+
+    painter.setClipRect(ev->rect());
+
+    color.setAlpha(128);
+    painter.setPen(color);
+
+    if (band == RectangleBand) {
+      color.setAlpha(64);
+      painter.setBrush(color);
+      painter.drawRect(QRectF(p1, p2).normalized());
+    } else {
+      painter.drawLine(p1, p2);
+    }
+  }
+}
+
 void ImageLabel::resizeEvent(QResizeEvent *)
 {
   emit resized();
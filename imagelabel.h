@@ -19,19 +19,34 @@
 
 #pragma once
 
+#include <QColor>
 #include <QLabel>
+#include <QTimer>
+
+class Overlay;
 
 class ImageLabel : public QLabel
 {
     Q_OBJECT
   public:
+    enum RubberBand {
+      NoBand, LineBand, RectangleBand
+    };
+
     explicit ImageLabel(QWidget *parent = 0);
+
+    void setOverlay(Overlay const* overlay, qreal zoom);
+    void setRubberBand(RubberBand shape, QPoint const& p1, QPoint const& p2);
+    void setRubberBandColor(QColor const& color);
+    void clearRubberBand();
+    void updateImageRect(QRect const& rect);
     
   protected:
     void mouseDoubleClickEvent(QMouseEvent *ev);
     void mouseMoveEvent(QMouseEvent *ev);
     void mousePressEvent(QMouseEvent *ev);
     void mouseReleaseEvent(QMouseEvent *ev);
+    void paintEvent(QPaintEvent *ev);
     void resizeEvent(QResizeEvent *);
 
   signals:
@@ -42,5 +57,20 @@ class ImageLabel : public QLabel
     void resized();
     
   public slots:
-    
+
+  private slots:
+    void flushHover();
+
+  private:
+    Overlay const* overlay;
+    qreal zoom;
+    RubberBand band;
+    QPoint bandP1, bandP2;
+    QColor bandColor;
+    QPoint hoverPos;
+    bool hoverPending;
+    QTimer hoverTimer;
+
+    QRect target() const;
+    QRect bandRect() const;
 };
@@ -0,0 +1,194 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "lookuptable.h"
+
+#include "pointwise.h"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+  // Four values per load and store
+  void mapBand(Band& band)
+  {
+    uchar const* t = static_cast<uchar const*>(band.data);
+
+    for (int i = band.first; i < band.last; i++) {
+      uchar const* p = band.src->ptr<uchar>(i);
+      uchar* q = band.result->ptr<uchar>(i);
+      size_t j = band.begin;
+
+      for (; j + 4 <= band.end; j += 4) {
+        quint32 word;
+        std::memcpy(&word, p + j, 4);
+
+        word = quint32(t[word & 0xff]) |
+               quint32(t[(word >> 8) & 0xff]) << 8 |
+               quint32(t[(word >> 16) & 0xff]) << 16 |
+               quint32(t[word >> 24]) << 24;
+
+        std::memcpy(q + j, &word, 4);
+      }
+
+      for (; j < band.end; j++)
+        q[j] = t[p[j]];
+    }
+  }
+}
+
+LookupTable::LookupTable()
+{
+  for (int i = 0; i < 256; i++)
+    table[i] = uchar(i);
+}
+
+LookupTable LookupTable::invert()
+{
+  LookupTable lut;
+
+  for (int i = 0; i < 256; i++)
+    lut.table[i] = uchar(255 - i);
+
+  return lut;
+}
+
+LookupTable LookupTable::stretch(int min, int max)
+{
+  LookupTable lut;
+  double scale = max > min ? 255.0 / (max - min) : 0;
+
+  for (int i = 0; i < 256; i++)
+    lut.table[i] = cv::saturate_cast<uchar>((i - min) * scale);
+
+  return lut;
+}
+
+LookupTable LookupTable::stretch(std::vector<unsigned int> const& counts)
+{
+  int min = 0;
+  int max = int(counts.size()) - 1;
+
+  while (min < max && counts[min] == 0)
+    min++;
+
+  while (max > min && counts[max] == 0)
+    max--;
+
+  return stretch(min, max);
+}
+
+LookupTable LookupTable::equalize(std::vector<unsigned int> const& counts)
+{
+  LookupTable lut;
+  int first = 0;
+  unsigned int total = 0;
+
+  for (int i = 0; i < 256; i++)
+    total += counts[i];
+
+  while (first < 256 && counts[first] == 0)
+    first++;
+
+  if (first == 256)
+    return lut;
+
+  if (counts[first] == total) {
+    std::fill(lut.table, lut.table + 256, uchar(first));
+    return lut;
+  }
+
+  float scale = 255.f / (total - counts[first]);
+  unsigned int sum = 0;
+
+  std::fill(lut.table, lut.table + first + 1, uchar(0));
+
+  for (int i = first + 1; i < 256; i++) {
+    sum += counts[i];
+    lut.table[i] = cv::saturate_cast<uchar>(sum * scale);
+  }
+
+  return lut;
+}
+
+LookupTable LookupTable::threshold(int value, int maxValue, int type)
+{
+  LookupTable lut;
+  uchar const top = cv::saturate_cast<uchar>(maxValue);
+
+  for (int i = 0; i < 256; i++) {
+    bool above = i > value;
+
+    switch (type & cv::THRESH_MASK) {
+      case cv::THRESH_BINARY:
+        lut.table[i] = above ? top : 0;
+        break;
+      case cv::THRESH_BINARY_INV:
+        lut.table[i] = above ? 0 : top;
+        break;
+      case cv::THRESH_TRUNC:
+        lut.table[i] = above ? cv::saturate_cast<uchar>(value) : uchar(i);
+        break;
+      case cv::THRESH_TOZERO:
+        lut.table[i] = above ? uchar(i) : 0;
+        break;
+      case cv::THRESH_TOZERO_INV:
+        lut.table[i] = above ? 0 : uchar(i);
+        break;
+    }
+  }
+
+  return lut;
+}
+
+LookupTable LookupTable::then(LookupTable const& next) const
+{
+  LookupTable lut;
+
+  for (int i = 0; i < 256; i++)
+    lut.table[i] = next.table[table[i]];
+
+  return lut;
+}
+
+// Four values per load and store, so the bands of a continuous image are
+// split on words
+void LookupTable::apply(cv::Mat const& src, cv::Mat& result) const
+{
+  CV_Assert(src.depth() == CV_8U);
+
+  result.create(src.size(), src.type());
+
+  if (!src.empty())
+    runBands(src, result, 4, mapBand, table);
+}
+
+void LookupTable::apply(std::vector<unsigned int>& counts) const
+{
+  std::vector<unsigned int> mapped(counts.size(), 0);
+
+  for (size_t i = 0; i < counts.size() && i < 256; i++)
+    mapped[table[i]] += counts[i];
+
+  counts.swap(mapped);
+}
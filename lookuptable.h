@@ -0,0 +1,58 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+// A pointwise operation on 8 bits images: every value of every channel is
+// replaced by its entry in the table. Tables compose, so a chain of
+// operations is a single table applied in a single pass.
+class LookupTable
+{
+  public:
+    // The identity
+    LookupTable();
+
+    static LookupTable invert();
+    // Maps [min, max] onto [0, 255], as cv::normalize with NORM_MINMAX
+    static LookupTable stretch(int min, int max);
+    // From the histogram of the image, over its first and last used values
+    static LookupTable stretch(std::vector<unsigned int> const& counts);
+    // From the histogram of the image, as cv::equalizeHist
+    static LookupTable equalize(std::vector<unsigned int> const& counts);
+    // The types of cv::threshold, without THRESH_OTSU
+    static LookupTable threshold(int value, int maxValue, int type);
+
+    // This table followed by next
+    LookupTable then(LookupTable const& next) const;
+
+    // result may be src, which must be 8 bits.
+    void apply(cv::Mat const& src, cv::Mat& result) const;
+
+    // The counts of an image after the table, from those before it
+    void apply(std::vector<unsigned int>& counts) const;
+
+    uchar operator[](int value) const { return table[value]; }
+
+  private:
+    uchar table[256];
+};
@@ -20,9 +20,11 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+#include <QDockWidget>
 #include <QFileDialog>
 
 #include "image.h"
+#include "lookuptable.h"
 
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
@@ -32,14 +34,15 @@
 #include "aboutwindow.h"
 #include "blurwindow.h"
 #include "cannywindow.h"
+#include "clahewindow.h"
 #include "gradientwindow.h"
 #include "histogramwindow.h"
+#include "mergewindow.h"
 #include "morphologywindow.h"
 #include "thresholdwindow.h"
 #include "setscalewindow.h"
 
 // TODO: Batch processing
-// TODO: Channels merge
 // TODO: Macroing
 // TODO: Video processing...?
 // TODO: Watershed
@@ -50,8 +53,12 @@ MainWindow::MainWindow(QWidget *parent) :
   workingImage(0),
   aboutWindow(0),
   cannyWindow(0),
+  claheWindow(0),
   gradientWindow(0),
   histogramWindow(0),
+  selectionHistogram(0),
+  selectionDock(0),
+  mergeWindow(0),
   morphologyWindow(0),
   thresholdWindow(0)
 {
@@ -72,6 +79,24 @@ void MainWindow::on_actionAbout_triggered()
   aboutWindow = new AboutWindow(this);
 }
 
+void MainWindow::on_actionAdaptive_Equalize_triggered()
+{
+  if (workingImage) {
+    if (workingImage->current.type() == CV_8UC1) {
+      disableOtherTabs();
+      setOperationsEnabled(false);
+
+      claheWindow = new ClaheWindow(workingImage, this);
+
+      connect(claheWindow,  SIGNAL(destroyed()),
+              this,         SLOT(enableAllTabs()));
+
+      connect(claheWindow,  SIGNAL(destroyed()),
+              this,         SLOT(enableAllOperations()));
+    }
+  }
+}
+
 void MainWindow::on_actionBlur_triggered()
 {
   if (workingImage) {
@@ -117,6 +142,18 @@ void MainWindow::on_actionCrop_triggered()
     connect(workingImage, SIGNAL(rectangleSelected(QRect)),
             this,         SLOT(crop(QRect)));
 
+    connect(workingImage, SIGNAL(selectionChanged(QRect)),
+            this,         SLOT(showSelectionHistogram(QRect)));
+
+    // Follows the selection while it is dragged
+    selectionDock = new QDockWidget("Selection", this);
+    selectionHistogram = new HistogramWindow(workingImage->current,
+                                             selectionDock);
+    selectionHistogram->setWindowFlags(Qt::Widget);
+    selectionDock->setWidget(selectionHistogram);
+    selectionDock->setFeatures(QDockWidget::NoDockWidgetFeatures);
+    addDockWidget(Qt::RightDockWidgetArea, selectionDock);
+
     connect(workingImage,   SIGNAL(status(QString)),
             ui->statusBar,  SLOT(showMessage(QString)));
 
@@ -159,13 +196,8 @@ void MainWindow::on_actionDistance_triggered()
 void MainWindow::on_actionEqualize_triggered()
 {
   if (workingImage) {
-    if (workingImage->current.channels() == 1) {
-      workingImage->backup();
-
-      cv::equalizeHist(workingImage->previous, workingImage->current);
-
-      workingImage->update();
-    }
+    if (workingImage->current.type() == CV_8UC1)
+      workingImage->apply(LookupTable::equalize(workingImage->histogram()));
   }
 }
 
@@ -232,13 +264,13 @@ void MainWindow::on_actionHSV_triggered()
     if (workingImage->current.channels() == 3) {
       int index = ui->imagesTabWidget->currentIndex();
       QString name = ui->imagesTabWidget->tabText(index);
-      std::vector<cv::Mat> hsv;
+      cv::Mat hsv;
 
       workingImage->HSV(hsv);
 
       for (int i = 0; i < 3; i++) {
         QString newName;
-        Image* newImage = new Image(hsv.at(i), this);
+        Image* newImage = new Image(hsv, i, this);
         images.push_back(newImage);
 
         switch (i) {
@@ -260,20 +292,35 @@ void MainWindow::on_actionHSV_triggered()
 }
 
 void MainWindow::on_actionInvert_triggered()
+{
+  if (workingImage)
+    workingImage->invert();
+}
+
+void MainWindow::on_actionMerge_triggered()
 {
   if (workingImage) {
-    std::vector<cv::Mat> channels;
+    QList<Image*> tabs;
+    QStringList names;
+
+    for (int i = 0; i < ui->imagesTabWidget->count(); i++) {
+      tabs.append((Image*)ui->imagesTabWidget->widget(i));
+      names.append(ui->imagesTabWidget->tabText(i));
+    }
 
-    workingImage->backup();
+    disableOtherTabs();
+    setOperationsEnabled(false);
 
-    cv::split(workingImage->current, channels);
+    mergeWindow = new MergeWindow(tabs, names, this);
 
-    for (size_t i = 0; i < channels.size(); i++)
-      channels.at(i) = 255 - channels.at(i);
+    connect(mergeWindow,  SIGNAL(merged(cv::Mat)),
+            this,         SLOT(merge(cv::Mat)));
 
-    cv::merge(channels, workingImage->current);
+    connect(mergeWindow,  SIGNAL(destroyed()),
+            this,         SLOT(enableAllTabs()));
 
-    workingImage->update();
+    connect(mergeWindow,  SIGNAL(destroyed()),
+            this,         SLOT(enableAllOperations()));
   }
 }
 
@@ -327,16 +374,16 @@ void MainWindow::on_actionParticles_triggered()
     if (workingImage->current.channels() == 1 && workingImage->areas == 0)  {
       workingImage->clearOverlay();
 
-      cv::Mat labels(workingImage->current.rows,
-                     workingImage->current.cols,
-                     CV_32S);
+      cv::RunLengthLabels labels;
       std::vector<cv::ConnectedComponentStats> stats;
+      std::vector<cv::ConnectedComponentShape> shapes;
 
-      cv::connectedComponentsWithStats(labels,
-                                       workingImage->current,
-                                       stats);
+      cv::connectedComponentsRunsWithShape(workingImage->current,
+                                           labels,
+                                           stats,
+                                           shapes);
 
-      workingImage->overlayAreas(stats);
+      workingImage->overlayAreas(stats, shapes);
     }
   }
 }
@@ -353,13 +400,11 @@ void MainWindow::on_actionRGB_triggered()
     if (workingImage->current.channels() == 3) {
       int index = ui->imagesTabWidget->currentIndex();
       QString name = ui->imagesTabWidget->tabText(index);
-      std::vector<cv::Mat> rgb;
-
-      workingImage->RGB(rgb);
 
+      // Views on the BGR channels of the image
       for (int i = 0; i < 3; i++) {
         QString newName;
-        Image* newImage = new Image(rgb.at(i), this);
+        Image* newImage = new Image(workingImage->current, 2 - i, this);
         images.push_back(newImage);
 
         switch (i) {
@@ -424,18 +469,29 @@ void MainWindow::on_actionSet_Scale_triggered()
   }
 }
 
+// The range of a gray image is read from its histogram
 void MainWindow::on_actionStretch_triggered()
 {
   if (workingImage) {
-    workingImage->backup();
+    if (workingImage->current.type() == CV_8UC1) {
+      workingImage->apply(LookupTable::stretch(workingImage->histogram()));
+    } else if (workingImage->current.depth() == CV_8U) {
+      double min, max;
+
+      cv::minMaxLoc(workingImage->current.reshape(1), &min, &max);
+
+      workingImage->apply(LookupTable::stretch(int(min), int(max)));
+    } else {
+      workingImage->backup();
 
-    cv::normalize(workingImage->previous,
-                  workingImage->current,
-                  0,
-                  255,
-                  cv::NORM_MINMAX);
+      cv::normalize(workingImage->previous,
+                    workingImage->current,
+                    0,
+                    255,
+                    cv::NORM_MINMAX);
 
-    workingImage->update();
+      workingImage->update();
+    }
   }
 }
 
@@ -463,15 +519,14 @@ void MainWindow::on_actionUndo_triggered()
     workingImage->undo();
 }
 
+// The image that is left keeps its pixmap and overlay, so coming back to it
+// doesn't convert it again.
 void MainWindow::on_imagesTabWidget_currentChanged(QWidget *image)
 {
-  if (workingImage)
-    workingImage->clearOverlay();
-
   workingImage = (Image*)image;
 
   if (workingImage != 0)
-    workingImage->update();
+    workingImage->refresh();
 }
 
 void MainWindow::on_imagesTabWidget_tabCloseRequested(int index)
@@ -489,7 +544,7 @@ void MainWindow::crop(QRect rect)
 
   if (rect.width() != 0 && rect.height() != 0) {
     cv::Rect roi(rect.x(), rect.y(), rect.width(), rect.height());
-    cv::Mat mat = workingImage->current(roi);
+    cv::Mat mat = workingImage->current(roi).clone();
 
     Image* newImage = new Image(mat, this);
     images.push_back(newImage);
@@ -503,12 +558,33 @@ void MainWindow::crop(QRect rect)
   disconnect(workingImage,  SIGNAL(rectangleSelected(QRect)),
              this,          SLOT(crop(QRect)));
 
+  disconnect(workingImage,  SIGNAL(selectionChanged(QRect)),
+             this,          SLOT(showSelectionHistogram(QRect)));
+
+  delete selectionDock;
+  selectionDock = 0;
+  selectionHistogram = 0;
+
   disconnect(workingImage,  SIGNAL(status(QString)),
              ui->statusBar, SLOT(showMessage(QString)));
 
   ui->statusBar->clearMessage();
 }
 
+void MainWindow::merge(cv::Mat const& image)
+{
+  Image* newImage = new Image(image, this);
+  images.push_back(newImage);
+
+  ui->imagesTabWidget->addTab(newImage, QLatin1String("Merge"));
+}
+
+void MainWindow::showSelectionHistogram(QRect const& rect)
+{
+  if (selectionHistogram)
+    selectionHistogram->showRegion(workingImage->regionHistogram(), rect);
+}
+
 void MainWindow::disableOtherTabs()
 {
   if (workingImage) {
@@ -557,6 +633,7 @@ void MainWindow::releaseStatusBar()
 
 void MainWindow::setOperationsEnabled(bool enable)
 {
+  ui->actionAdaptive_Equalize->setEnabled(enable);
   ui->actionBlur->setEnabled(enable);
   ui->actionCanny->setEnabled(enable);
   ui->actionCrop->setEnabled(enable);
@@ -567,6 +644,7 @@ void MainWindow::setOperationsEnabled(bool enable)
   ui->actionHistogram->setEnabled(enable);
   ui->actionHSV->setEnabled(enable);
   ui->actionInvert->setEnabled(enable);
+  ui->actionMerge->setEnabled(enable);
   ui->actionMorphology->setEnabled(enable);
   ui->actionOpen->setEnabled(enable);
   ui->actionParticles->setEnabled(enable);
@@ -23,11 +23,19 @@
 
 class Image;
 
+class QDockWidget;
+
+namespace cv {
+  class Mat;
+}
+
 class AboutWindow;
 class BlurWindow;
 class CannyWindow;
+class ClaheWindow;
 class GradientWindow;
 class HistogramWindow;
+class MergeWindow;
 class MorphologyWindow;
 class ThresholdWindow;
 class SetScaleWindow;
@@ -46,6 +54,7 @@ class MainWindow : public QMainWindow
 
   private slots:
     void on_actionAbout_triggered();
+    void on_actionAdaptive_Equalize_triggered();
     void on_actionBlur_triggered();
     void on_actionCanny_triggered();
     void on_actionCrop_triggered();
@@ -58,6 +67,7 @@ class MainWindow : public QMainWindow
     void on_actionHistogram_triggered();
     void on_actionHSV_triggered();
     void on_actionInvert_triggered();
+    void on_actionMerge_triggered();
     void on_actionMorphology_triggered();
     void on_actionOpen_triggered();
     void on_actionParticles_triggered();
@@ -73,6 +83,8 @@ class MainWindow : public QMainWindow
     void on_imagesTabWidget_tabCloseRequested(int index);
 
     void crop(QRect rect);
+    void merge(cv::Mat const& image);
+    void showSelectionHistogram(QRect const& rect);
     void disableOtherTabs();
     void enableAllOperations();
     void enableAllTabs();
@@ -86,8 +98,12 @@ class MainWindow : public QMainWindow
     AboutWindow *aboutWindow;
     BlurWindow *blurWindow;
     CannyWindow *cannyWindow;
+    ClaheWindow *claheWindow;
     GradientWindow *gradientWindow;
     HistogramWindow *histogramWindow;
+    HistogramWindow *selectionHistogram;
+    QDockWidget *selectionDock;
+    MergeWindow *mergeWindow;
     MorphologyWindow *morphologyWindow;
     ThresholdWindow *thresholdWindow;
     SetScaleWindow *setScaleWindow;
@@ -21,45 +21,84 @@
 
 #include <opencv2/core/core.hpp>
 
-QImage Mat2QImage(cv::Mat const& src)
-{
-  QImage dest(src.cols, src.rows, QImage::Format_ARGB32);
+#include <QThread>
+#include <QtConcurrentMap>
 
-  const float scale = 255.0;
+namespace {
+  struct Band {
+      cv::Mat const* src;
+      uchar* dest;
+      int bytesPerLine;
+      int first;
+      int last;
+  };
 
-  if (src.depth() == CV_8U) {
-    if (src.channels() == 1) {
-      for (int i = 0; i < src.rows; ++i) {
-        for (int j = 0; j < src.cols; ++j) {
-          int level = src.at<quint8>(i, j);
-          dest.setPixel(j, i, qRgb(level, level, level));
-        }
-      }
-    } else if (src.channels() == 3) {
-      for (int i = 0; i < src.rows; ++i) {
-        for (int j = 0; j < src.cols; ++j) {
-          cv::Vec3b bgr = src.at<cv::Vec3b>(i, j);
-          dest.setPixel(j, i, qRgb(bgr[2], bgr[1], bgr[0]));
-        }
-      }
-    }
-  } else if (src.depth() == CV_32F) {
-    if (src.channels() == 1) {
-      for (int i = 0; i < src.rows; ++i) {
-        for (int j = 0; j < src.cols; ++j) {
-          int level = scale * src.at<float>(i, j);
-          dest.setPixel(j, i, qRgb(level, level, level));
+  void convertBand(Band& band)
+  {
+    cv::Mat const& src = *band.src;
+    const float scale = 255.0;
+
+    for (int i = band.first; i < band.last; ++i) {
+      QRgb* dest = reinterpret_cast<QRgb*>(band.dest + i * band.bytesPerLine);
+
+      if (src.depth() == CV_8U) {
+        if (src.channels() == 1) {
+          quint8 const* level = src.ptr<quint8>(i);
+
+          for (int j = 0; j < src.cols; ++j)
+            dest[j] = qRgb(level[j], level[j], level[j]);
+        } else if (src.channels() == 3) {
+          cv::Vec3b const* bgr = src.ptr<cv::Vec3b>(i);
+
+          for (int j = 0; j < src.cols; ++j)
+            dest[j] = qRgb(bgr[j][2], bgr[j][1], bgr[j][0]);
         }
-      }
-    } else if (src.channels() == 3) {
-      for (int i = 0; i < src.rows; ++i) {
-        for (int j = 0; j < src.cols; ++j) {
-          cv::Vec3f bgr = scale * src.at<cv::Vec3f>(i, j);
-          dest.setPixel(j, i, qRgb(bgr[2], bgr[1], bgr[0]));
+      } else if (src.depth() == CV_32F) {
+        if (src.channels() == 1) {
+          float const* value = src.ptr<float>(i);
+
+          for (int j = 0; j < src.cols; ++j) {
+            int level = scale * value[j];
+            dest[j] = qRgb(level, level, level);
+          }
+        } else if (src.channels() == 3) {
+          cv::Vec3f const* value = src.ptr<cv::Vec3f>(i);
+
+          for (int j = 0; j < src.cols; ++j) {
+            cv::Vec3f bgr = scale * value[j];
+            dest[j] = qRgb(bgr[2], bgr[1], bgr[0]);
+          }
         }
       }
     }
   }
+}
+
+// The rows are written straight into the image memory, split in bands that
+// are converted by the global thread pool.
+QImage Mat2QImage(cv::Mat const& src)
+{
+  QImage dest(src.cols, src.rows, QImage::Format_ARGB32);
+
+  if (src.empty())
+    return dest;
+
+  QVector<Band> bands;
+  int count = qBound(1, 4 * QThread::idealThreadCount(), src.rows);
+
+  for (int k = 0; k < count; k++) {
+    Band band;
+
+    band.src = &src;
+    band.dest = dest.bits();
+    band.bytesPerLine = dest.bytesPerLine();
+    band.first = k * src.rows / count;
+    band.last = (k + 1) * src.rows / count;
+
+    bands.append(band);
+  }
+
+  QtConcurrent::blockingMap(bands, convertBand);
 
   return dest;
 }
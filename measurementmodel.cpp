@@ -0,0 +1,140 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "measurementmodel.h"
+
+#include <limits>
+
+MeasurementModel::MeasurementModel(QStringList const& columns,
+                                   QStringList const& units,
+                                   QObject *parent) :
+  QAbstractTableModel(parent),
+  columns(columns),
+  units(units)
+{
+}
+
+void MeasurementModel::append(QVector<double> const& values)
+{
+  int n = values.size() / columns.size();
+
+  if (n == 0)
+    return;
+
+  int first = rowCount();
+
+  beginInsertRows(QModelIndex(), first, first + n - 1);
+  this->values += values.mid(0, n * columns.size());
+  endInsertRows();
+}
+
+double MeasurementModel::value(int row, int column) const
+{
+  return values.at(row * columns.size() + column);
+}
+
+int MeasurementModel::measurements() const
+{
+  return columns.size();
+}
+
+int MeasurementModel::rowCount(QModelIndex const& parent) const
+{
+  if (parent.isValid())
+    return 0;
+
+  return values.size() / columns.size();
+}
+
+int MeasurementModel::columnCount(QModelIndex const& parent) const
+{
+  if (parent.isValid())
+    return 0;
+
+  return columns.size();
+}
+
+QVariant MeasurementModel::data(QModelIndex const& index, int role) const
+{
+  if (!index.isValid())
+    return QVariant();
+
+  if (role == Qt::DisplayRole)
+    return value(index.row(), index.column());
+
+  if (role == Qt::TextAlignmentRole)
+    return int(Qt::AlignRight | Qt::AlignVCenter);
+
+  return QVariant();
+}
+
+QVariant MeasurementModel::headerData(int section,
+                                      Qt::Orientation orientation,
+                                      int role) const
+{
+  if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+    return QVariant();
+
+  if (units.value(section).isEmpty())
+    return columns.at(section);
+
+  return columns.at(section) + " (" + units.at(section) + ")";
+}
+
+MeasurementFilter::MeasurementFilter(QObject *parent) :
+  QSortFilterProxyModel(parent),
+  column(-1),
+  min(-std::numeric_limits<double>::infinity()),
+  max(std::numeric_limits<double>::infinity())
+{
+}
+
+// A negative column removes the filter.
+void MeasurementFilter::setRange(int column, double min, double max)
+{
+  this->column = column;
+  this->min = min;
+  this->max = max;
+
+  invalidateFilter();
+}
+
+bool MeasurementFilter::filterAcceptsRow(int row, QModelIndex const&) const
+{
+  MeasurementModel const* model =
+      static_cast<MeasurementModel const*>(sourceModel());
+
+  if (column < 0 || column >= model->measurements())
+    return true;
+
+  double value = model->value(row, column);
+
+  return min <= value && value <= max;
+}
+
+// Compares the doubles directly instead of going through QVariant.
+bool MeasurementFilter::lessThan(QModelIndex const& left,
+                                 QModelIndex const& right) const
+{
+  MeasurementModel const* model =
+      static_cast<MeasurementModel const*>(sourceModel());
+
+  return model->value(left.row(), left.column()) <
+         model->value(right.row(), right.column());
+}
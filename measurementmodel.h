@@ -0,0 +1,79 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QSortFilterProxyModel>
+#include <QStringList>
+#include <QVector>
+
+// Table of numeric measurements. The values are kept row-major in a single
+// vector, so a table of 100k particles is one allocation, and the views only
+// ask for the cells they show. Each column has its own unit, shown in its
+// header; an empty unit is a plain number.
+class MeasurementModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+  public:
+    MeasurementModel(QStringList const& columns,
+                     QStringList const& units,
+                     QObject *parent = 0);
+
+    // Appends values.size() / columns rows at once.
+    void append(QVector<double> const& values);
+    double value(int row, int column) const;
+
+    int measurements() const;
+
+    int rowCount(QModelIndex const& parent = QModelIndex()) const;
+    int columnCount(QModelIndex const& parent = QModelIndex()) const;
+    QVariant data(QModelIndex const& index,
+                  int role = Qt::DisplayRole) const;
+    QVariant headerData(int section,
+                        Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const;
+
+  private:
+    QStringList columns;
+    QStringList units;
+    QVector<double> values;
+};
+
+// Sorts the measurements by value and hides the rows whose value in the
+// filtered column is out of [min, max].
+class MeasurementFilter : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+  public:
+    explicit MeasurementFilter(QObject *parent = 0);
+
+    void setRange(int column, double min, double max);
+
+  protected:
+    bool filterAcceptsRow(int row, QModelIndex const& parent) const;
+    bool lessThan(QModelIndex const& left, QModelIndex const& right) const;
+
+  private:
+    int column;
+    double min;
+    double max;
+};
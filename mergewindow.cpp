@@ -0,0 +1,153 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mergewindow.h"
+#include "ui_mergewindow.h"
+
+#include "histogramengine.h"
+#include "image.h"
+#include "lookuptable.h"
+#include "pointwise.h"
+
+#include <opencv2/core/core.hpp>
+
+namespace {
+  enum Table {
+    Identity, Stretch, Equalize
+  };
+
+  LookupTable table(cv::Mat const& image, int channel, int type)
+  {
+    std::vector<unsigned int> counts;
+
+    switch (type) {
+      case Stretch:
+        calculateHistogram(image, channel, 256, 0, 256, counts);
+
+        return LookupTable::stretch(counts);
+      case Equalize:
+        calculateHistogram(image, channel, 256, 0, 256, counts);
+
+        return LookupTable::equalize(counts);
+      default:
+        return LookupTable();
+    }
+  }
+}
+
+// Only 8 bits single channel images are offered. Channel views are read
+// from the image they were taken from, without being extracted.
+MergeWindow::MergeWindow(QList<Image*> const& images,
+                         QStringList const& names,
+                         QWidget *parent) :
+  QMainWindow(parent),
+  ui(new Ui::MergeWindow)
+{
+  ui->setupUi(this);
+
+  QComboBox* sources[] = {
+    ui->redComboBox, ui->greenComboBox, ui->blueComboBox
+  };
+
+  for (int i = 0; i < images.size(); i++) {
+    int channel;
+    cv::Mat const& image = images.at(i)->channelSource(channel);
+
+    if (image.depth() == CV_8U && (channel >= 0 || image.channels() == 1)) {
+      this->images.append(images.at(i));
+
+      for (int k = 0; k < 3; k++)
+        sources[k]->addItem(names.at(i));
+    }
+  }
+
+  // Red, green and blue from the first three by default
+  for (int k = 0; k < 3; k++)
+    sources[k]->setCurrentIndex(qMin(k + 1, this->images.size()));
+
+  this->setAttribute(Qt::WA_DeleteOnClose);
+  this->setFixedSize(this->size());
+
+  this->show();
+}
+
+MergeWindow::~MergeWindow()
+{
+  delete ui;
+}
+
+void MergeWindow::on_cancelPushButton_clicked()
+{
+  this->close();
+}
+
+// The first entry of each list is "None", a channel of zeros. An inverted
+// channel composes its table with the inversion, it's still mapped once.
+void MergeWindow::on_okPushButton_clicked()
+{
+  QComboBox* sources[] = {
+    ui->blueComboBox, ui->greenComboBox, ui->redComboBox
+  };
+  QComboBox* tables[] = {
+    ui->blueTableComboBox, ui->greenTableComboBox, ui->redTableComboBox
+  };
+  QCheckBox* inverted[] = {
+    ui->blueInvertedCheckBox, ui->greenInvertedCheckBox, ui->redInvertedCheckBox
+  };
+
+  std::vector<cv::Mat> planes(3);
+  std::vector<int> channels(3, 0);
+  std::vector<LookupTable> luts(3);
+  cv::Size size;
+
+  for (int k = 0; k < 3; k++) {
+    int index = sources[k]->currentIndex() - 1;
+
+    if (index < 0)
+      continue;
+
+    int channel;
+    planes[k] = images.at(index)->channelSource(channel);
+    channels[k] = qMax(channel, 0);
+    luts[k] = table(planes[k], channels[k], tables[k]->currentIndex());
+
+    if (inverted[k]->isChecked())
+      luts[k] = luts[k].then(LookupTable::invert());
+
+    if (size.area() != 0 && planes[k].size() != size) {
+      ui->messageLabel->setText(QLatin1String("The images differ in size"));
+      return;
+    }
+
+    size = planes[k].size();
+  }
+
+  if (size.area() == 0) {
+    ui->messageLabel->setText(QLatin1String("No image selected"));
+    return;
+  }
+
+  cv::Mat color;
+
+  mergeChannels(planes, channels, luts, color);
+
+  emit merged(color);
+
+  this->close();
+}
@@ -0,0 +1,59 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QList>
+#include <QMainWindow>
+#include <QStringList>
+
+namespace cv {
+  class Mat;
+}
+
+class Image;
+class QComboBox;
+
+namespace Ui {
+  class MergeWindow;
+}
+
+// Builds a color image from single channel images, each mapped by a table.
+// Any image can go to any channel, for false color composites.
+class MergeWindow : public QMainWindow
+{
+    Q_OBJECT
+    
+  public:
+    explicit MergeWindow(QList<Image*> const& images,
+                         QStringList const& names,
+                         QWidget *parent = 0);
+    ~MergeWindow();
+    
+  signals:
+    void merged(cv::Mat const& image);
+
+  private slots:
+    void on_cancelPushButton_clicked();
+    void on_okPushButton_clicked();
+
+  private:
+    Ui::MergeWindow *ui;
+    QList<Image*> images;
+};
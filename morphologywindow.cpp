@@ -168,6 +168,8 @@ void MorphologyWindow::on_sizeSpinBox_valueChanged(int)
 
 void MorphologyWindow::morphology()
 {
+  image->detach();
+
   int iterations = ui->iterationsSpinBox->value();
 
   if (ui->closeRadioButton->isChecked()) {
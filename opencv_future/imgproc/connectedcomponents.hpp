@@ -56,9 +56,105 @@ namespace cv {
       double centroid_y;//!< centroid row
       uint64 integral_x;//!< sum of all columns where the image was non-zero
       uint64 integral_y;//!< sum of all rows where the image was non-zero
-      unsigned int area;//!< count of all non-zero pixels
+      uint64 area;//!< count of all non-zero pixels, as wide as the 64-bit labels
   };
 
+  struct CV_EXPORTS ConnectedComponentShape
+  {
+      double perimeter;//!< boundary length (including holes) measured along the pixel edges with a corner correction
+      double orientation;//!< angle in radians between the columns axis and the major axis, clockwise as rows grow downwards
+      double eccentricity;//!< eccentricity of the ellipse with the same second order central moments
+      double major_axis;//!< major axis length of that ellipse
+      double minor_axis;//!< minor axis length of that ellipse
+      double equivalent_diameter;//!< diameter of the circle with the same area
+      double convex_area;//!< area of the convex hull of the pixel squares
+      double circularity;//!< 4*pi*area/perimeter^2, 1 for a perfect circle
+      double feret_max;//!< largest caliper diameter of the convex hull
+      double feret_min;//!< smallest caliper diameter of the convex hull
+  };
+
+  struct CV_EXPORTS ConnectedComponentRun
+  {
+      int row;//!< row of the run
+      int start;//!< first column of the run
+      int end;//!< one past the last column of the run
+      int label;//!< component the run belongs to
+  };
+
+  //! Label map stored as the runs of non-zero pixels, for images that are mostly background
+  class CV_EXPORTS RunLengthLabels
+  {
+    public:
+      RunLengthLabels();
+
+      int at(int r, int c) const;//!< label of a single pixel
+      void expandRow(int r, int *Lrow) const;//!< writes the cols labels of row r
+      void expand(CV_OUT Mat &L) const;//!< writes the whole CV_32S label plane
+      void componentRuns(int label, CV_OUT std::vector<ConnectedComponentRun> &cruns) const;//!< runs of one component
+
+      int rows;
+      int cols;
+      int nLabels;//!< number of labels, including the background
+      std::vector<ConnectedComponentRun> runs;//!< all the runs in raster order
+      std::vector<size_t> rowStart;//!< runs of row r are runs[rowStart[r]] up to runs[rowStart[r + 1] - 1]
+      std::vector<size_t> labelStart;//!< runs of label l are labelRuns[labelStart[l]] up to labelRuns[labelStart[l + 1] - 1]
+      std::vector<size_t> labelRuns;//!< indices into runs, grouped by label and in raster order within a label
+  };
+
+  //! Supplies the rows of an image one at a time
+  class CV_EXPORTS RowSource
+  {
+    public:
+      virtual ~RowSource() {}
+      virtual bool read(CV_OUT Mat &row) = 0;//!< fills the 1 x cols CV_8U row, returns false past the last row
+  };
+
+  //! Receives every component as soon as it is complete
+  class CV_EXPORTS ConnectedComponentSink
+  {
+    public:
+      virtual ~ConnectedComponentSink() {}
+      virtual void component(const ConnectedComponentStats &stats) = 0;
+  };
+
+  //! Row by row labeling whose memory only depends on the image width. It keeps the runs of two rows and the
+  //! statistics of the components that are still open, a component is handed to the sink on the first row that
+  //! doesn't extend it.
+  class CV_EXPORTS ConnectedComponentsStream
+  {
+    public:
+      ConnectedComponentsStream(int cols, ConnectedComponentSink &sink, int connectivity = 8);
+
+      void push(const Mat &row);//!< labels the next 1 x cols CV_8U or CV_8S row
+      void finish();//!< completes the components still open
+      int count() const;//!< components handed to the sink so far
+
+    private:
+      int cols;
+      int connectivity;
+      int row;
+      int emitted;
+      ConnectedComponentSink &sink;
+      std::vector<ConnectedComponentRun> prevRuns;//!< runs of the previous row, labelled with their open component
+      std::vector<ConnectedComponentRun> curRuns;
+      std::vector<ConnectedComponentStats> open;//!< statistics of the open components
+      std::vector<ConnectedComponentStats> nextOpen;
+      std::vector<int> P;//!< union find tree of the open components and the runs of the current row
+      std::vector<int> live;
+
+      void emit(ConnectedComponentStats &stats);
+  };
+
+  //! Narrowest label type that can't overflow for an image of this size: CV_8U, CV_16U, CV_32S, or CV_32SC2 for
+  //! 64-bit labels. An empty L passed to the functions below is created with this type, otherwise L's type is used
+  //! and running out of labels raises CV_StsOutOfRange
+  CV_EXPORTS int connectedComponentsLabelType(int rows, int cols, int connectivity = 8);
+
   CV_EXPORTS_W int connectedComponents(CV_OUT Mat &L, const Mat &I, int connectivity = 8);
   CV_EXPORTS_W int connectedComponentsWithStats(CV_OUT Mat &L, const Mat &I, CV_OUT std::vector<ConnectedComponentStats> &statsv, int connectivity = 8);
+  CV_EXPORTS_W int connectedComponentsWithShape(CV_OUT Mat &L, const Mat &I, CV_OUT std::vector<ConnectedComponentStats> &statsv, CV_OUT std::vector<ConnectedComponentShape> &shapev, int connectivity = 8);
+  CV_EXPORTS_W int connectedComponentsRuns(const Mat &I, CV_OUT RunLengthLabels &rle, int connectivity = 8);
+  CV_EXPORTS_W int connectedComponentsRunsWithStats(const Mat &I, CV_OUT RunLengthLabels &rle, CV_OUT std::vector<ConnectedComponentStats> &statsv, int connectivity = 8);
+  CV_EXPORTS_W int connectedComponentsRunsWithShape(const Mat &I, CV_OUT RunLengthLabels &rle, CV_OUT std::vector<ConnectedComponentStats> &statsv, CV_OUT std::vector<ConnectedComponentShape> &shapev, int connectivity = 8);
+  CV_EXPORTS int connectedComponentsStream(RowSource &source, int cols, ConnectedComponentSink &sink, int connectivity = 8);
 }
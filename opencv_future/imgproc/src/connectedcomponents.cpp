@@ -43,17 +43,24 @@
 
 #include "../connectedcomponents.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 namespace cv{
   namespace connectedcomponents{
 
+    //Statistics operators are fed every pixel with its provisional label during the scanning phase. Provisional
+    //labels are announced with initElement() as they are created and, once the union find tree has been flattened,
+    //merge() folds every provisional label into its final label. This avoids a second full image sweep just to
+    //compute the statistics.
     template<typename LabelT>
     struct NoOp{
         NoOp(){
         }
-        void init(const LabelT labels){
-          (void) labels;
+        inline
+        void initElement(const LabelT l){
+          (void) l;
         }
         inline
         void operator()(int r, int c, LabelT l){
@@ -61,59 +68,381 @@ namespace cv{
           (void) c;
           (void) l;
         }
+        void init(const LabelT labels){
+          (void) labels;
+        }
+        inline
+        void merge(LabelT dst, LabelT src){
+          (void) dst;
+          (void) src;
+        }
         void finish(){}
     };
+
+    //Statistics of a component without pixels
+    inline static
+    cv::ConnectedComponentStats emptyStats(){
+      cv::ConnectedComponentStats stats = cv::ConnectedComponentStats();
+      stats.lower_x = std::numeric_limits<int>::max();
+      stats.lower_y = std::numeric_limits<int>::max();
+      stats.upper_x = std::numeric_limits<int>::min();
+      stats.upper_y = std::numeric_limits<int>::min();
+      stats.centroid_x = 0;
+      stats.centroid_y = 0;
+      stats.integral_x = 0;
+      stats.integral_y = 0;
+      stats.area = 0;
+      return stats;
+    }
+
+    //Add the pixels start to end - 1 of row r
+    inline static
+    void addRun(cv::ConnectedComponentStats &stats, int r, int start, int end){
+      const uint64 len = end - start;
+      stats.lower_x = std::min(stats.lower_x, start);
+      stats.upper_x = std::max(stats.upper_x, end - 1);
+      stats.lower_y = std::min(stats.lower_y, r);
+      stats.upper_y = std::max(stats.upper_y, r);
+      stats.integral_x += (uint64(start) + end - 1) * len / 2;
+      stats.integral_y += uint64(r) * len;
+      stats.area += len;
+    }
+
+    //Fold the statistics of src into dst
+    inline static
+    void mergeStats(cv::ConnectedComponentStats &dst, const cv::ConnectedComponentStats &src){
+      dst.lower_x = std::min(dst.lower_x, src.lower_x);
+      dst.lower_y = std::min(dst.lower_y, src.lower_y);
+      dst.upper_x = std::max(dst.upper_x, src.upper_x);
+      dst.upper_y = std::max(dst.upper_y, src.upper_y);
+      dst.integral_x += src.integral_x;
+      dst.integral_y += src.integral_y;
+      dst.area += src.area;
+    }
+
+    inline static
+    void finishStats(cv::ConnectedComponentStats &stats){
+      stats.centroid_x = stats.integral_x / double(stats.area);
+      stats.centroid_y = stats.integral_y / double(stats.area);
+    }
+
     template<typename LabelT>
     struct CCStatsOp{
         std::vector<cv::ConnectedComponentStats> &statsv;
-        CCStatsOp(std::vector<cv::ConnectedComponentStats> &_statsv): statsv(_statsv){
+        std::vector<cv::ConnectedComponentStats> pstatsv;//statistics of the provisional labels
+        cv::ConnectedComponentStats empty;
+        CCStatsOp(std::vector<cv::ConnectedComponentStats> &_statsv): statsv(_statsv), empty(emptyStats()){
         }
         inline
-        void init(const LabelT nlabels){
-          statsv.clear();
-          cv::ConnectedComponentStats stats = cv::ConnectedComponentStats();
-          stats.lower_x = std::numeric_limits<LabelT>::max();
-          stats.lower_y = std::numeric_limits<LabelT>::max();
-          stats.upper_x = std::numeric_limits<LabelT>::min();
-          stats.upper_y = std::numeric_limits<LabelT>::min();
-          stats.centroid_x = 0;
-          stats.centroid_y = 0;
-          stats.integral_x = 0;
-          stats.integral_y = 0;
-          stats.area = 0;
-          statsv.resize(nlabels, stats);
+        void initElement(const LabelT l){
+          //provisional labels are created in increasing order
+          assert(size_t(l) == pstatsv.size());
+          (void) l;
+          pstatsv.push_back(empty);
         }
+        inline
         void operator()(int r, int c, LabelT l){
-          ConnectedComponentStats &stats = statsv[l];
+          ConnectedComponentStats &stats = pstatsv[l];
           if(c > stats.upper_x){
             stats.upper_x = c;
-          }else{
-            if(c < stats.lower_x){
-              stats.lower_x = c;
-            }
+          }
+          if(c < stats.lower_x){
+            stats.lower_x = c;
           }
           if(r > stats.upper_y){
             stats.upper_y = r;
-          }else{
-            if(r < stats.lower_y){
-              stats.lower_y = r;
-            }
+          }
+          if(r < stats.lower_y){
+            stats.lower_y = r;
           }
           stats.integral_x += c;
           stats.integral_y += r;
           stats.area++;
         }
+        void init(const LabelT nlabels){
+          statsv.clear();
+          statsv.resize(nlabels, empty);
+        }
+        inline
+        void merge(LabelT dst, LabelT src){
+          mergeStats(statsv[dst], pstatsv[src]);
+        }
         void finish(){
+          pstatsv.clear();
           for(size_t l = 0; l < statsv.size(); ++l){
-            ConnectedComponentStats &stats = statsv[l];
-            stats.lower_x = std::min(stats.lower_x, stats.upper_x);
-            stats.lower_y = std::min(stats.lower_y, stats.upper_y);
-            stats.centroid_x = stats.integral_x / double(stats.area);
-            stats.centroid_y = stats.integral_y / double(stats.area);
+            finishStats(statsv[l]);
           }
         }
     };
 
+    //Per component accumulators behind ConnectedComponentShape
+    struct ShapeMoments{
+        double xx;//!< sum of the squared columns
+        double yy;//!< sum of the squared rows
+        double xy;//!< sum of the column * row products
+        uint64 edges;//!< pixel edges between the component and the background
+        uint64 corners;//!< vertices where the outline turns
+    };
+
+    //Account the 2x2 window of labels tl, tr, bl and br around a grid vertex: the edge between tr and br, the edge
+    //between bl and br and the outline corners at the vertex. Visiting every vertex of the grid once, the ones on the
+    //image border included, counts every exposed pixel edge and every corner exactly once
+    template<typename LabelT>
+    inline static
+    void shapeWindow(ShapeMoments *m, LabelT tl, LabelT tr, LabelT bl, LabelT br){
+      if(!tr != !br){
+        m[tr ? tr : br].edges++;
+      }
+      if(!bl != !br){
+        m[bl ? bl : br].edges++;
+      }
+      const int n = !!tl + !!tr + !!bl + !!br;
+      if(n == 1 || n == 3){
+        //with 3 pixels set the window is 4-connected, so any of them gives the component
+        m[tl ? tl : (tr ? tr : (bl ? bl : br))].corners++;
+      }else if(n == 2 && !tl == !br){
+        //two pixels touching by a vertex, each one turns there
+        m[tl ? tl : tr].corners++;
+        m[br ? br : bl].corners++;
+      }
+    }
+
+    struct HullPoint{
+        int64 x;
+        int64 y;
+        bool operator<(const HullPoint &p) const{
+          return x < p.x || (x == p.x && y < p.y);
+        }
+        bool operator==(const HullPoint &p) const{
+          return x == p.x && y == p.y;
+        }
+    };
+
+    inline static
+    int64 cross(const HullPoint &o, const HullPoint &a, const HullPoint &b){
+      return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+
+    //The hull of the pixel squares of a component only depends on the corners at both ends of its runs
+    inline static
+    void addRunCorners(std::vector<HullPoint> &pts, int r, int start, int end){
+      HullPoint p0 = {start, r};
+      HullPoint p1 = {start, r + 1};
+      HullPoint p2 = {end, r};
+      HullPoint p3 = {end, r + 1};
+      pts.push_back(p0);
+      pts.push_back(p1);
+      pts.push_back(p2);
+      pts.push_back(p3);
+    }
+
+    //Andrew's monotone chain, leaves the counter clockwise hull in pts
+    static
+    void convexHull(std::vector<HullPoint> &pts){
+      std::sort(pts.begin(), pts.end());
+      pts.erase(std::unique(pts.begin(), pts.end()), pts.end());
+      const size_t n = pts.size();
+      if(n < 3){
+        return;
+      }
+      std::vector<HullPoint> hull(2 * n);
+      size_t k = 0;
+      for(size_t i = 0; i < n; ++i){
+        while(k >= 2 && cross(hull[k - 2], hull[k - 1], pts[i]) <= 0){
+          k--;
+        }
+        hull[k++] = pts[i];
+      }
+      for(size_t i = n - 1, t = k + 1; i > 0; --i){
+        while(k >= t && cross(hull[k - 2], hull[k - 1], pts[i - 1]) <= 0){
+          k--;
+        }
+        hull[k++] = pts[i - 1];
+      }
+      hull.resize(k - 1);
+      pts.swap(hull);
+    }
+
+    //Area and rotating calipers over a counter clockwise hull
+    static
+    void hullMeasures(const std::vector<HullPoint> &h, cv::ConnectedComponentShape &shape){
+      const size_t n = h.size();
+      int64 area2 = 0;
+      for(size_t i = 0; i < n; ++i){
+        const HullPoint &a = h[i];
+        const HullPoint &b = h[(i + 1) % n];
+        area2 += a.x * b.y - b.x * a.y;
+      }
+      shape.convex_area = area2 / 2.0;
+
+      int64 dmax2 = 0;
+      double dmin = std::numeric_limits<double>::max();
+      size_t j = 1;
+      for(size_t i = 0; i < n; ++i){
+        const HullPoint &a = h[i];
+        const HullPoint &b = h[(i + 1) % n];
+        while(cross(a, b, h[(j + 1) % n]) > cross(a, b, h[j])){
+          j = (j + 1) % n;
+        }
+        const double dx = double(b.x - a.x);
+        const double dy = double(b.y - a.y);
+        dmin = std::min(dmin, cross(a, b, h[j]) / std::sqrt(dx * dx + dy * dy));
+        for(int e = 0; e < 2; ++e){
+          const HullPoint &p = e ? b : a;
+          const int64 ex = h[j].x - p.x;
+          const int64 ey = h[j].y - p.y;
+          dmax2 = std::max(dmax2, ex * ex + ey * ey);
+        }
+      }
+      shape.feret_max = std::sqrt(double(dmax2));
+      shape.feret_min = dmin;
+    }
+
+    //Fill the shape of a component from its statistics, its accumulators and the run corners in pts
+    static
+    void computeShape(const cv::ConnectedComponentStats &stats, const ShapeMoments &m, std::vector<HullPoint> &pts,
+                      cv::ConnectedComponentShape &shape){
+      const double area = stats.area;
+
+      shape.perimeter = m.edges - m.corners * (2.0 - std::sqrt(2.0)) / 2.0;
+      shape.equivalent_diameter = std::sqrt(4.0 * area / CV_PI);
+      shape.circularity = 4.0 * CV_PI * area / (shape.perimeter * shape.perimeter);
+
+      const double mu20 = m.xx / area - stats.centroid_x * stats.centroid_x;
+      const double mu02 = m.yy / area - stats.centroid_y * stats.centroid_y;
+      const double mu11 = m.xy / area - stats.centroid_x * stats.centroid_y;
+      const double common = std::sqrt(0.25 * (mu20 - mu02) * (mu20 - mu02) + mu11 * mu11);
+      const double lambda1 = 0.5 * (mu20 + mu02) + common;
+      const double lambda2 = std::max(0.5 * (mu20 + mu02) - common, 0.0);
+      shape.orientation = 0.5 * std::atan2(2.0 * mu11, mu20 - mu02);
+      shape.major_axis = 4.0 * std::sqrt(lambda1);
+      shape.minor_axis = 4.0 * std::sqrt(lambda2);
+      shape.eccentricity = lambda1 > 0 ? std::sqrt(1.0 - lambda2 / lambda1) : 0.0;
+
+      convexHull(pts);
+      hullMeasures(pts, shape);
+    }
+
+    //Shape descriptors on top of CCStatsOp, still computed in the single labeling scan. The operator keeps the
+    //provisional labels of the previous and the current row to visit every 2x2 window of the grid, sums the second
+    //order moments per provisional label and keeps the row runs to build the convex hull of each component afterwards.
+    template<typename LabelT>
+    struct CCShapeOp{
+        struct Run{
+            LabelT l;
+            int r;
+            int start;
+            int end;
+        };
+
+        CCStatsOp<LabelT> statsOp;
+        std::vector<cv::ConnectedComponentShape> &shapev;
+        const int rows;
+        const int cols;
+        std::vector<ShapeMoments> pmomentsv;//moments of the provisional labels
+        std::vector<ShapeMoments> momentsv;
+        std::vector<LabelT> finalv;//final label of every provisional label
+        std::vector<Run> runs;
+        std::vector<LabelT> Lbuf[2];
+        LabelT *Lprev;//provisional labels of the previous row, Lprev[-1] is always background
+        LabelT *Lcur;//provisional labels of the current row, Lcur[-1] is always background
+
+        CCShapeOp(std::vector<cv::ConnectedComponentStats> &_statsv, std::vector<cv::ConnectedComponentShape> &_shapev,
+                  int _rows, int _cols): statsOp(_statsv), shapev(_shapev), rows(_rows), cols(_cols){
+          Lbuf[0].assign(cols + 1, 0);
+          Lbuf[1].assign(cols + 1, 0);
+          Lprev = &Lbuf[0][1];
+          Lcur = &Lbuf[1][1];
+        }
+        inline
+        void initElement(const LabelT l){
+          statsOp.initElement(l);
+          ShapeMoments m = ShapeMoments();
+          pmomentsv.push_back(m);
+        }
+        inline
+        void operator()(int r, int c, LabelT l){
+          statsOp(r, c, l);
+          Lcur[c] = l;
+          if(l){
+            ShapeMoments &m = pmomentsv[l];
+            m.xx += double(c) * c;
+            m.yy += double(r) * r;
+            m.xy += double(c) * r;
+            if(!Lcur[c - 1]){
+              Run run = {l, r, c, c + 1};
+              runs.push_back(run);
+            }else{
+              runs.back().end = c + 1;
+            }
+          }
+          ShapeMoments *m = &pmomentsv[0];
+          shapeWindow(m, Lprev[c - 1], Lprev[c], Lcur[c - 1], l);
+          if(r == rows - 1){
+            shapeWindow<LabelT>(m, Lcur[c - 1], l, 0, 0);
+          }
+          if(c == cols - 1){
+            shapeWindow<LabelT>(m, Lprev[c], 0, l, 0);
+            if(r == rows - 1){
+              shapeWindow<LabelT>(m, l, 0, 0, 0);
+            }
+            std::swap(Lprev, Lcur);
+          }
+        }
+        void init(const LabelT nlabels){
+          statsOp.init(nlabels);
+          ShapeMoments m = ShapeMoments();
+          momentsv.assign(nlabels, m);
+          finalv.resize(pmomentsv.size());
+        }
+        inline
+        void merge(LabelT dst, LabelT src){
+          statsOp.merge(dst, src);
+          ShapeMoments &m = momentsv[dst];
+          const ShapeMoments &pm = pmomentsv[src];
+          m.xx += pm.xx;
+          m.yy += pm.yy;
+          m.xy += pm.xy;
+          m.edges += pm.edges;
+          m.corners += pm.corners;
+          finalv[src] = dst;
+        }
+        void finish(){
+          statsOp.finish();
+          const std::vector<cv::ConnectedComponentStats> &statsv = statsOp.statsv;
+          const size_t nlabels = statsv.size();
+
+          //bucket the runs by final label, keeping the raster order
+          std::vector<size_t> first(nlabels + 1, 0);
+          for(size_t i = 0; i < runs.size(); ++i){
+            first[finalv[runs[i].l] + 1]++;
+          }
+          for(size_t l = 0; l < nlabels; ++l){
+            first[l + 1] += first[l];
+          }
+          std::vector<size_t> order(runs.size());
+          std::vector<size_t> next(first.begin(), first.end() - 1);
+          for(size_t i = 0; i < runs.size(); ++i){
+            order[next[finalv[runs[i].l]]++] = i;
+          }
+
+          cv::ConnectedComponentShape empty = cv::ConnectedComponentShape();
+          shapev.clear();
+          shapev.resize(nlabels, empty);
+          std::vector<HullPoint> pts;
+          for(size_t l = 1; l < nlabels; ++l){
+            pts.clear();
+            for(size_t i = first[l]; i < first[l + 1]; ++i){
+              const Run &run = runs[order[i]];
+              addRunCorners(pts, run.r, run.start, run.end);
+            }
+            computeShape(statsv[l], momentsv[l], pts, shapev[l]);
+          }
+          runs.clear();
+          pmomentsv.clear();
+        }
+    };
+
     //Find the root of the tree of node i
     template<typename LabelT>
     inline static
@@ -177,6 +506,25 @@ namespace cv{
       return k;
     }
 
+    //Upper bound of the provisional labels, background included. A new provisional label is only created for a pixel
+    //whose already scanned neighbors are all background, so those pixels can never touch each other: at most one per
+    //2x2 block for 8-way and one per checkerboard square for 4-way.
+    inline static
+    size_t maxLabels(int rows, int cols, int connectivity){
+      if(connectivity == 4){
+        return (size_t(rows) * size_t(cols) + 1)/2 + 1;
+      }
+      return (size_t(rows + 2 - 1)/2) * (size_t(cols + 2 - 1)/2) + 1;
+    }
+
+    //Label planes of the narrowest type are created when the caller passes an empty one
+    inline static
+    void createLabels(Mat &L, const Mat &I, int connectivity){
+      if(L.empty()){
+        L.create(I.rows, I.cols, connectedComponentsLabelType(I.rows, I.cols, connectivity));
+      }
+    }
+
     //Based on "Two Strategies to Speed up Connected Components Algorithms", the SAUF (Scan array union find) variant
     //using decision trees
     //Kesheng Wu, et al
@@ -190,13 +538,11 @@ namespace cv{
         LabelT operator()(Mat &L, const Mat &I, StatsOp &sop){
           const int rows = L.rows;
           const int cols = L.cols;
-          size_t Plength = (size_t(rows + 3 - 1)/3) * (size_t(cols + 3 - 1)/3);
-          if(connectivity == 4){
-            Plength = 4 * Plength;//a quick and dirty upper bound, an exact answer exists if you want to find it
-            //the 4 comes from the fact that a 3x3 block can never have more than 4 unique labels
-          }
+          //labels past the range of LabelT are reported as they show up, the bound is usually far from reached
+          const size_t Plength = std::min(maxLabels(rows, cols, connectivity), size_t(std::numeric_limits<LabelT>::max()));
           LabelT *P = (LabelT *) fastMalloc(sizeof(LabelT) * Plength);
           P[0] = 0;
+          sop.initElement(0);
           LabelT lunique = 1;
           //scanning phase
           for(int r_i = 0; r_i < rows; ++r_i){
@@ -223,6 +569,7 @@ namespace cv{
               for(int c_i = 0; Irows[0] != Irow + cols; ++Irows[0], c_i++){
                 if(!*Irows[0]){
                   Lrow[c_i] = 0;
+                  sop(r_i, c_i, 0);
                   continue;
                 }
                 Irows[1] = Irow_prev + c_i;
@@ -261,13 +608,19 @@ namespace cv{
                         *Lrows[0] = *(Lrows[G8[d][0]] + G8[d][1]);
                       }else{
                         //new label
+                        if(size_t(lunique) == Plength){
+                          fastFree(P);
+                          CV_Error(CV_StsOutOfRange, "too many components for the label type");
+                        }
                         *Lrows[0] = lunique;
                         P[lunique] = lunique;
+                        sop.initElement(lunique);
                         lunique = lunique + 1;
                       }
                     }
                   }
                 }
+                sop(r_i, c_i, *Lrows[0]);
               }
             }else{
               //B & D only
@@ -278,6 +631,7 @@ namespace cv{
               for(int c_i = 0; Irows[0] != Irow + cols; ++Irows[0], c_i++){
                 if(!*Irows[0]){
                   Lrow[c_i] = 0;
+                  sop(r_i, c_i, 0);
                   continue;
                 }
                 Irows[1] = Irow_prev + c_i;
@@ -299,11 +653,17 @@ namespace cv{
                     *Lrows[0] = *(Lrows[G4[d][0]] + G4[d][1]);
                   }else{
                     //new label
+                    if(size_t(lunique) == Plength){
+                      fastFree(P);
+                      CV_Error(CV_StsOutOfRange, "too many components for the label type");
+                    }
                     *Lrows[0] = lunique;
                     P[lunique] = lunique;
+                    sop.initElement(lunique);
                     lunique = lunique + 1;
                   }
                 }
+                sop(r_i, c_i, *Lrows[0]);
               }
             }
           }
@@ -312,14 +672,17 @@ namespace cv{
           LabelT nLabels = flattenL(P, lunique);
           sop.init(nLabels);
 
+          //fold the statistics of every provisional label into its final label
+          for(LabelT i = 0; i < lunique; ++i){
+            sop.merge(P[i], i);
+          }
+
+          //relabeling is now a plain lookup, statistics were gathered while scanning
           for(int r_i = 0; r_i < rows; ++r_i){
             LabelT *Lrow_start = (LabelT *)(L.data + L.step.p[0] * r_i);
             LabelT *Lrow_end = Lrow_start + cols;
-            LabelT *Lrow = Lrow_start;
-            for(int c_i = 0; Lrow != Lrow_end; ++Lrow, ++c_i){
-              const LabelT l = P[*Lrow];
-              *Lrow = l;
-              sop(r_i, c_i, l);
+            for(LabelT *Lrow = Lrow_start; Lrow != Lrow_end; ++Lrow){
+              *Lrow = P[*Lrow];
             }
           }
 
@@ -330,6 +693,230 @@ namespace cv{
         }//End function LabelingImpl operator()
 
     };//End struct LabelingImpl
+
+    //Run based labeling for sparse images. Every row is encoded as the runs of its non-zero pixels and each run is a
+    //node of the union find tree, united with the runs it touches in the previous row. Provisional label k + 1 stands
+    //for run k, so flattening numbers the components in the same raster order as LabelingImpl does.
+    //Append the runs of non-zero pixels of row r
+    static
+    void findRuns(const uint8_t *Irow, int cols, int r, std::vector<ConnectedComponentRun> &runs){
+      int c_i = 0;
+      while(c_i < cols){
+        //skip the background a word at a time
+        while(c_i + 8 <= cols){
+          uint64 w;
+          memcpy(&w, Irow + c_i, sizeof(w));
+          if(w){
+            break;
+          }
+          c_i += 8;
+        }
+        while(c_i < cols && !Irow[c_i]){
+          ++c_i;
+        }
+        if(c_i == cols){
+          break;
+        }
+        ConnectedComponentRun run;
+        run.row = r;
+        run.start = c_i;
+        while(c_i < cols && Irow[c_i]){
+          ++c_i;
+        }
+        run.end = c_i;
+        run.label = 0;
+        runs.push_back(run);
+      }
+    }
+
+    static
+    int labelRuns(const Mat &I, int connectivity, RunLengthLabels &rle){
+      const int rows = I.rows;
+      const int cols = I.cols;
+      //8-way runs also touch when their ends are diagonal neighbors
+      const int reach = connectivity == 8 ? 1 : 0;
+      std::vector<ConnectedComponentRun> &runs = rle.runs;
+      runs.clear();
+      rle.rowStart.assign(rows + 1, 0);
+      std::vector<int> P(1, 0);
+      size_t prevStart = 0;
+      for(int r_i = 0; r_i < rows; ++r_i){
+        const uint8_t *Irow = (const uint8_t *)(I.data + I.step.p[0] * r_i);
+        const size_t curStart = runs.size();
+        rle.rowStart[r_i] = curStart;
+        findRuns(Irow, cols, r_i, runs);
+
+        //unite with the overlapping runs of the previous row, both rows are sorted so a cursor is enough
+        size_t p = prevStart;
+        if(runs.size() >= size_t(std::numeric_limits<int>::max())){
+          CV_Error(CV_StsOutOfRange, "too many runs for the run labels");
+        }
+        for(size_t k = curStart; k < runs.size(); ++k){
+          const int l = int(k) + 1;
+          P.push_back(l);
+          const ConnectedComponentRun &run = runs[k];
+          while(p < curStart && runs[p].end + reach <= run.start){
+            ++p;
+          }
+          for(size_t q = p; q < curStart && runs[q].start < run.end + reach; ++q){
+            set_union(&P[0], int(q) + 1, l);
+          }
+        }
+        prevStart = curStart;
+      }
+      rle.rowStart[rows] = runs.size();
+
+      const int nLabels = flattenL(&P[0], int(P.size()));
+      for(size_t k = 0; k < runs.size(); ++k){
+        runs[k].label = P[k + 1];
+      }
+
+      //group the runs by label
+      rle.rows = rows;
+      rle.cols = cols;
+      rle.nLabels = nLabels;
+      rle.labelStart.assign(nLabels + 1, 0);
+      for(size_t k = 0; k < runs.size(); ++k){
+        rle.labelStart[runs[k].label + 1]++;
+      }
+      for(int l = 0; l < nLabels; ++l){
+        rle.labelStart[l + 1] += rle.labelStart[l];
+      }
+      rle.labelRuns.resize(runs.size());
+      std::vector<size_t> next(rle.labelStart.begin(), rle.labelStart.end() - 1);
+      for(size_t k = 0; k < runs.size(); ++k){
+        rle.labelRuns[next[runs[k].label]++] = k;
+      }
+
+      return nLabels;
+    }
+
+    //Same statistics as CCStatsOp, in closed form over every run. The background is whatever the runs leave uncovered
+    static
+    void runStats(const RunLengthLabels &rle, std::vector<cv::ConnectedComponentStats> &statsv){
+      CCStatsOp<int> sop(statsv);
+      sop.init(rle.nLabels);
+      const uint64 rowIntegral = uint64(rle.cols) * (rle.cols - 1) / 2;
+      ConnectedComponentStats &bg = statsv[0];
+      for(int r = 0; r < rle.rows; ++r){
+        uint64 covered = 0;
+        uint64 coveredIntegral = 0;
+        int firstBg = 0;
+        int lastBg = rle.cols - 1;
+        for(size_t k = rle.rowStart[r]; k < rle.rowStart[r + 1]; ++k){
+          const ConnectedComponentRun &run = rle.runs[k];
+          const uint64 len = run.end - run.start;
+          addRun(statsv[run.label], r, run.start, run.end);
+          covered += len;
+          coveredIntegral += (uint64(run.start) + run.end - 1) * len / 2;
+          if(run.start == firstBg){
+            firstBg = run.end;
+          }
+          if(run.end - 1 == lastBg){
+            lastBg = run.start - 1;
+          }
+        }
+        const uint64 uncovered = rle.cols - covered;
+        if(uncovered){
+          bg.lower_x = std::min(bg.lower_x, firstBg);
+          bg.upper_x = std::max(bg.upper_x, lastBg);
+          bg.lower_y = std::min(bg.lower_y, r);
+          bg.upper_y = std::max(bg.upper_y, r);
+          bg.integral_x += rowIntegral - coveredIntegral;
+          bg.integral_y += uint64(r) * uncovered;
+          bg.area += uncovered;
+        }
+      }
+      sop.finish();
+    }
+
+    //Walks the runs of a row for increasing columns
+    struct RunCursor{
+        const ConnectedComponentRun *it;
+        const ConnectedComponentRun *end;
+        inline
+        int at(int c){
+          while(it != end && it->end <= c){
+            ++it;
+          }
+          return (it != end && it->start <= c) ? it->label : 0;
+        }
+    };
+
+    //Same descriptors as CCShapeOp. Along each horizontal line of the grid the 2x2 windows only change at the ends
+    //of the runs above and below it, so the windows in between are accounted in bulk.
+    static
+    void runShapes(const RunLengthLabels &rle, const std::vector<cv::ConnectedComponentStats> &statsv,
+                   std::vector<cv::ConnectedComponentShape> &shapev){
+      const ConnectedComponentRun *runs = rle.runs.empty() ? 0 : &rle.runs[0];
+      ShapeMoments empty = ShapeMoments();
+      std::vector<ShapeMoments> momentsv(rle.nLabels, empty);
+      ShapeMoments *m = &momentsv[0];
+
+      for(size_t k = 0; k < rle.runs.size(); ++k){
+        const ConnectedComponentRun &run = runs[k];
+        const double len = run.end - run.start;
+        const double first = run.start;
+        const double last = run.end - 1;
+        const double sx = (first + last) * len / 2;
+        const double sxx = (last * (last + 1) * (2 * last + 1) - (first - 1) * first * (2 * first - 1)) / 6;
+        m[run.label].xx += sxx;
+        m[run.label].yy += double(run.row) * run.row * len;
+        m[run.label].xy += double(run.row) * sx;
+      }
+
+      std::vector<int> xs;
+      for(int r = 0; r <= rle.rows; ++r){
+        const size_t a0 = r > 0 ? rle.rowStart[r - 1] : 0;
+        const size_t a1 = r > 0 ? rle.rowStart[r] : 0;
+        const size_t b0 = r < rle.rows ? rle.rowStart[r] : 0;
+        const size_t b1 = r < rle.rows ? rle.rowStart[r + 1] : 0;
+        xs.clear();
+        for(size_t k = a0; k < a1; ++k){
+          xs.push_back(runs[k].start);
+          xs.push_back(runs[k].end);
+        }
+        const size_t mid = xs.size();
+        for(size_t k = b0; k < b1; ++k){
+          xs.push_back(runs[k].start);
+          xs.push_back(runs[k].end);
+        }
+        std::inplace_merge(xs.begin(), xs.begin() + mid, xs.end());
+        xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+
+        RunCursor aLeft = {runs + a0, runs + a1};
+        RunCursor aRight = aLeft;
+        RunCursor bLeft = {runs + b0, runs + b1};
+        RunCursor bRight = bLeft;
+        for(size_t i = 0; i < xs.size(); ++i){
+          const int x = xs[i];
+          const int tr = aRight.at(x);
+          const int br = bRight.at(x);
+          shapeWindow(m, aLeft.at(x - 1), tr, bLeft.at(x - 1), br);
+          if(i + 1 < xs.size() && !tr != !br){
+            m[tr ? tr : br].edges += xs[i + 1] - x - 1;
+          }
+        }
+      }
+
+      ConnectedComponentShape emptyShape = ConnectedComponentShape();
+      shapev.clear();
+      shapev.resize(rle.nLabels, emptyShape);
+      std::vector<HullPoint> pts;
+      for(int l = 1; l < rle.nLabels; ++l){
+        pts.clear();
+        for(size_t i = rle.labelStart[l]; i < rle.labelStart[l + 1]; ++i){
+          const ConnectedComponentRun &run = runs[rle.labelRuns[i]];
+          addRunCorners(pts, run.row, run.start, run.end);
+        }
+        computeShape(statsv[l], momentsv[l], pts, shapev[l]);
+      }
+    }
+
+    inline static
+    bool beforeRunEnd(int c, const ConnectedComponentRun &run){
+      return c < run.end;
+    }
   }//end namespace connectedcomponents
 
   //L's type must have an appropriate depth for the number of pixels in I
@@ -337,15 +924,31 @@ namespace cv{
   int connectedComponents_sub1(Mat &L, const Mat &I, int connectivity, StatsOp &sop){
     CV_Assert(L.rows == I.rows);
     CV_Assert(L.cols == I.cols);
-    CV_Assert(L.channels() == 1 && I.channels() == 1);
+    CV_Assert((L.channels() == 1 || L.type() == CV_32SC2) && I.channels() == 1);
     CV_Assert(connectivity == 8 || connectivity == 4);
 
     int lDepth = L.depth();
     int iDepth = I.depth();
     using connectedcomponents::LabelingImpl;
-    //warn if L's depth is not sufficient?
+    //L's depth only has to hold the components actually found, LabelingImpl fails once it runs out of labels
 
-    if(lDepth == CV_8U){
+    if(L.type() == CV_32SC2){
+      //64-bit labels, each one takes the two ints of an element since Mat has no 64-bit integer depth
+      if(iDepth == CV_8U || iDepth == CV_8S){
+        uint64 nLabels;
+        if(connectivity == 4){
+          nLabels = LabelingImpl<uint64, uint8_t, StatsOp, 4>()(L, I, sop);
+        }else{
+          nLabels = LabelingImpl<uint64, uint8_t, StatsOp, 8>()(L, I, sop);
+        }
+        if(nLabels > uint64(std::numeric_limits<int>::max())){
+          CV_Error(CV_StsOutOfRange, "the number of components doesn't fit the return value");
+        }
+        return (int) nLabels;
+      }else{
+        CV_Assert(false);
+      }
+    }else if(lDepth == CV_8U){
       if(iDepth == CV_8U || iDepth == CV_8S){
         if(connectivity == 4){
           return (int) LabelingImpl<uint8_t, uint8_t, StatsOp, 4>()(L, I, sop);
@@ -383,9 +986,24 @@ namespace cv{
     return -1;
   }
 
+  int connectedComponentsLabelType(int rows, int cols, int connectivity){
+    const size_t nLabels = connectedcomponents::maxLabels(rows, cols, connectivity);
+    if(nLabels <= size_t(std::numeric_limits<uint8_t>::max())){
+      return CV_8U;
+    }else if(nLabels <= size_t(std::numeric_limits<uint16_t>::max())){
+      return CV_16U;
+    }else if(nLabels <= size_t(std::numeric_limits<int32_t>::max())){
+      return CV_32S;
+    }
+    return CV_32SC2;
+  }
+
   int connectedComponents(Mat &L, const Mat &I, int connectivity){
+    connectedcomponents::createLabels(L, I, connectivity);
     int lDepth = L.depth();
-    if(lDepth == CV_8U){
+    if(L.type() == CV_32SC2){
+      connectedcomponents::NoOp<uint64> sop; return connectedComponents_sub1(L, I, connectivity, sop);
+    }else if(lDepth == CV_8U){
       connectedcomponents::NoOp<uint8_t> sop; return connectedComponents_sub1(L, I, connectivity, sop);
     }else if(lDepth == CV_16U){
       connectedcomponents::NoOp<uint16_t> sop; return connectedComponents_sub1(L, I, connectivity, sop);
@@ -398,8 +1016,11 @@ namespace cv{
   }
 
   int connectedComponentsWithStats(Mat &L, const Mat &I, std::vector<ConnectedComponentStats> &statsv, int connectivity){
+    connectedcomponents::createLabels(L, I, connectivity);
     int lDepth = L.depth();
-    if(lDepth == CV_8U){
+    if(L.type() == CV_32SC2){
+      connectedcomponents::CCStatsOp<uint64> sop(statsv); return connectedComponents_sub1(L, I, connectivity, sop);
+    }else if(lDepth == CV_8U){
       connectedcomponents::CCStatsOp<uint8_t> sop(statsv); return connectedComponents_sub1(L, I, connectivity, sop);
     }else if(lDepth == CV_16U){
       connectedcomponents::CCStatsOp<uint16_t> sop(statsv); return connectedComponents_sub1(L, I, connectivity, sop);
@@ -411,4 +1032,175 @@ namespace cv{
     }
   }
 
+  int connectedComponentsWithShape(Mat &L, const Mat &I, std::vector<ConnectedComponentStats> &statsv,
+                                   std::vector<ConnectedComponentShape> &shapev, int connectivity){
+    connectedcomponents::createLabels(L, I, connectivity);
+    int lDepth = L.depth();
+    if(L.type() == CV_32SC2){
+      connectedcomponents::CCShapeOp<uint64> sop(statsv, shapev, I.rows, I.cols); return connectedComponents_sub1(L, I, connectivity, sop);
+    }else if(lDepth == CV_8U){
+      connectedcomponents::CCShapeOp<uint8_t> sop(statsv, shapev, I.rows, I.cols); return connectedComponents_sub1(L, I, connectivity, sop);
+    }else if(lDepth == CV_16U){
+      connectedcomponents::CCShapeOp<uint16_t> sop(statsv, shapev, I.rows, I.cols); return connectedComponents_sub1(L, I, connectivity, sop);
+    }else if(lDepth == CV_32S){
+      connectedcomponents::CCShapeOp<uint32_t> sop(statsv, shapev, I.rows, I.cols); return connectedComponents_sub1(L, I, connectivity, sop);
+    }else{
+      CV_Assert(false);
+      return 0;
+    }
+  }
+
+  RunLengthLabels::RunLengthLabels(): rows(0), cols(0), nLabels(0){
+  }
+
+  int RunLengthLabels::at(int r, int c) const{
+    std::vector<ConnectedComponentRun>::const_iterator first = runs.begin() + rowStart[r];
+    std::vector<ConnectedComponentRun>::const_iterator last = runs.begin() + rowStart[r + 1];
+    std::vector<ConnectedComponentRun>::const_iterator it = std::upper_bound(first, last, c, connectedcomponents::beforeRunEnd);
+    return (it != last && it->start <= c) ? it->label : 0;
+  }
+
+  void RunLengthLabels::expandRow(int r, int *Lrow) const{
+    std::fill(Lrow, Lrow + cols, 0);
+    for(size_t k = rowStart[r]; k < rowStart[r + 1]; ++k){
+      const ConnectedComponentRun &run = runs[k];
+      std::fill(Lrow + run.start, Lrow + run.end, run.label);
+    }
+  }
+
+  void RunLengthLabels::expand(Mat &L) const{
+    L.create(rows, cols, CV_32S);
+    for(int r = 0; r < rows; ++r){
+      expandRow(r, (int *)(L.data + L.step.p[0] * r));
+    }
+  }
+
+  void RunLengthLabels::componentRuns(int label, std::vector<ConnectedComponentRun> &cruns) const{
+    cruns.clear();
+    for(size_t i = labelStart[label]; i < labelStart[label + 1]; ++i){
+      cruns.push_back(runs[labelRuns[i]]);
+    }
+  }
+
+  int connectedComponentsRuns(const Mat &I, RunLengthLabels &rle, int connectivity){
+    CV_Assert(I.channels() == 1);
+    CV_Assert(I.depth() == CV_8U || I.depth() == CV_8S);
+    CV_Assert(connectivity == 8 || connectivity == 4);
+    return connectedcomponents::labelRuns(I, connectivity, rle);
+  }
+
+  int connectedComponentsRunsWithStats(const Mat &I, RunLengthLabels &rle, std::vector<ConnectedComponentStats> &statsv,
+                                       int connectivity){
+    int nLabels = connectedComponentsRuns(I, rle, connectivity);
+    connectedcomponents::runStats(rle, statsv);
+    return nLabels;
+  }
+
+  int connectedComponentsRunsWithShape(const Mat &I, RunLengthLabels &rle, std::vector<ConnectedComponentStats> &statsv,
+                                       std::vector<ConnectedComponentShape> &shapev, int connectivity){
+    int nLabels = connectedComponentsRunsWithStats(I, rle, statsv, connectivity);
+    connectedcomponents::runShapes(rle, statsv, shapev);
+    return nLabels;
+  }
+
+  ConnectedComponentsStream::ConnectedComponentsStream(int _cols, ConnectedComponentSink &_sink, int _connectivity):
+    cols(_cols), connectivity(_connectivity), row(0), emitted(0), sink(_sink){
+    CV_Assert(connectivity == 8 || connectivity == 4);
+  }
+
+  //Every row gets its own small union find tree: the open components are nodes 0 to nPrev - 1 and the runs of the
+  //row follow them. Once the row is united, the roots without a run in it are complete and the rest are renumbered
+  //as the open components of the next row, so nothing grows with the image height.
+  void ConnectedComponentsStream::push(const Mat &I){
+    CV_Assert(I.rows == 1 && I.cols == cols && I.channels() == 1);
+    CV_Assert(I.depth() == CV_8U || I.depth() == CV_8S);
+    using namespace connectedcomponents;
+
+    const int reach = connectivity == 8 ? 1 : 0;
+    curRuns.clear();
+    findRuns((const uint8_t *)I.data, cols, row, curRuns);
+
+    const int nPrev = (int) open.size();
+    const int n = nPrev + (int) curRuns.size();
+    P.resize(n);
+    for(int i = 0; i < n; ++i){
+      P[i] = i;
+    }
+    open.resize(n, emptyStats());
+
+    size_t p = 0;
+    for(size_t k = 0; k < curRuns.size(); ++k){
+      const int id = nPrev + int(k);
+      const ConnectedComponentRun &run = curRuns[k];
+      addRun(open[id], row, run.start, run.end);
+      while(p < prevRuns.size() && prevRuns[p].end + reach <= run.start){
+        ++p;
+      }
+      for(size_t q = p; q < prevRuns.size() && prevRuns[q].start < run.end + reach; ++q){
+        set_union(&P[0], prevRuns[q].label, id);
+      }
+    }
+
+    //roots are the smallest node of their tree, so every node folds into an earlier one
+    for(int i = 0; i < n; ++i){
+      const int root = find(&P[0], i);
+      if(root != i){
+        mergeStats(open[root], open[i]);
+      }
+    }
+
+    live.assign(n, -1);
+    int nLive = 0;
+    for(size_t k = 0; k < curRuns.size(); ++k){
+      const int root = P[nPrev + k];
+      if(live[root] < 0){
+        live[root] = nLive++;
+      }
+      curRuns[k].label = live[root];
+    }
+
+    nextOpen.resize(nLive);
+    for(int i = 0; i < n; ++i){
+      if(P[i] == i){
+        if(live[i] < 0){
+          emit(open[i]);
+        }else{
+          nextOpen[live[i]] = open[i];
+        }
+      }
+    }
+
+    open.swap(nextOpen);
+    prevRuns.swap(curRuns);
+    row++;
+  }
+
+  void ConnectedComponentsStream::finish(){
+    for(size_t i = 0; i < open.size(); ++i){
+      emit(open[i]);
+    }
+    open.clear();
+    prevRuns.clear();
+  }
+
+  int ConnectedComponentsStream::count() const{
+    return emitted;
+  }
+
+  void ConnectedComponentsStream::emit(ConnectedComponentStats &stats){
+    connectedcomponents::finishStats(stats);
+    sink.component(stats);
+    emitted++;
+  }
+
+  int connectedComponentsStream(RowSource &source, int cols, ConnectedComponentSink &sink, int connectivity){
+    ConnectedComponentsStream stream(cols, sink, connectivity);
+    Mat row(1, cols, CV_8U);
+    while(source.read(row)){
+      stream.push(row);
+    }
+    stream.finish();
+    return stream.count();
+  }
+
 }
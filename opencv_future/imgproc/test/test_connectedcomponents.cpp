@@ -0,0 +1,217 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Parity check of connectedComponentsWithStats() against the labeling and
+// statistics it replaced: labels assigned in raster order of the first pixel
+// of each component, and statistics accumulated pixel by pixel over the
+// final labels, as the old second sweep did. Random binary images go
+// through both connectivities and every label type.
+
+#include <opencv_future/imgproc/connectedcomponents.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace {
+  cv::uint64 labelAt(cv::Mat const& L, int r, int c)
+  {
+    switch (L.type()) {
+      case CV_8U:
+        return L.at<uchar>(r, c);
+      case CV_16U:
+        return L.at<ushort>(r, c);
+      case CV_32S:
+        return cv::uint64(L.at<int>(r, c));
+      default:
+        return reinterpret_cast<cv::uint64 const*>(L.ptr(r))[c];
+    }
+  }
+
+  cv::ConnectedComponentStats emptyStats()
+  {
+    cv::ConnectedComponentStats stats = cv::ConnectedComponentStats();
+
+    stats.lower_x = stats.lower_y = std::numeric_limits<int>::max();
+    stats.upper_x = stats.upper_y = std::numeric_limits<int>::min();
+
+    return stats;
+  }
+
+  // The old CCStatsOp::operator()
+  void addPixel(cv::ConnectedComponentStats& stats, int r, int c)
+  {
+    stats.lower_x = std::min(stats.lower_x, c);
+    stats.upper_x = std::max(stats.upper_x, c);
+    stats.lower_y = std::min(stats.lower_y, r);
+    stats.upper_y = std::max(stats.upper_y, r);
+    stats.integral_x += c;
+    stats.integral_y += r;
+    stats.area++;
+  }
+
+  // Flood fill labels, numbered in raster order of their first pixel
+  int referenceLabels(cv::Mat const& I, int connectivity, std::vector<int>& labels)
+  {
+    int const rows = I.rows;
+    int const cols = I.cols;
+    int count = 1;
+
+    labels.assign(rows * cols, -1);
+
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < cols; c++) {
+        if (I.at<uchar>(r, c) == 0) {
+          labels[r * cols + c] = 0;
+          continue;
+        }
+
+        if (labels[r * cols + c] >= 0)
+          continue;
+
+        std::queue<std::pair<int, int> > queue;
+
+        labels[r * cols + c] = count;
+        queue.push(std::make_pair(r, c));
+
+        while (!queue.empty()) {
+          int y = queue.front().first;
+          int x = queue.front().second;
+
+          queue.pop();
+
+          for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+              int yy = y + dy;
+              int xx = x + dx;
+
+              if ((dy == 0 && dx == 0) || (connectivity == 4 && dy != 0 && dx != 0))
+                continue;
+
+              if (yy < 0 || xx < 0 || yy >= rows || xx >= cols)
+                continue;
+
+              if (I.at<uchar>(yy, xx) == 0 || labels[yy * cols + xx] >= 0)
+                continue;
+
+              labels[yy * cols + xx] = count;
+              queue.push(std::make_pair(yy, xx));
+            }
+          }
+        }
+
+        count++;
+      }
+    }
+
+    return count;
+  }
+
+  bool sameStats(cv::ConnectedComponentStats const& a,
+                 cv::ConnectedComponentStats const& b)
+  {
+    // An empty background has no box nor centroid
+    if (a.area == 0 || b.area == 0)
+      return a.area == b.area;
+
+    return a.area == b.area &&
+           a.integral_x == b.integral_x && a.integral_y == b.integral_y &&
+           a.lower_x == b.lower_x && a.upper_x == b.upper_x &&
+           a.lower_y == b.lower_y && a.upper_y == b.upper_y &&
+           std::abs(a.centroid_x - b.centroid_x) < 1e-9 &&
+           std::abs(a.centroid_y - b.centroid_y) < 1e-9;
+  }
+}
+
+int main()
+{
+  int const types[] = {CV_8U, CV_16U, CV_32S, CV_32SC2};
+  cv::RNG rng(26);
+  int failures = 0;
+  int checks = 0;
+
+  for (int iteration = 0; iteration < 2000; iteration++) {
+    int const type = types[iteration % 4];
+    int const connectivity = (iteration / 4) % 2 ? 8 : 4;
+    // 8 bits labels only fit the provisional labels of small images
+    int const size = type == CV_8U ? 15 : 64;
+    int const rows = rng.uniform(1, size + 1);
+    int const cols = rng.uniform(1, size + 1);
+    int const density = rng.uniform(0, 101);
+
+    cv::Mat I(rows, cols, CV_8U);
+
+    for (int r = 0; r < rows; r++)
+      for (int c = 0; c < cols; c++)
+        I.at<uchar>(r, c) = rng.uniform(0, 100) < density ? 255 : 0;
+
+    cv::Mat L(rows, cols, type);
+    std::vector<cv::ConnectedComponentStats> stats;
+    int count = cv::connectedComponentsWithStats(L, I, stats, connectivity);
+
+    std::vector<int> labels;
+    int expected = referenceLabels(I, connectivity, labels);
+
+    std::vector<cv::ConnectedComponentStats> swept(count, emptyStats());
+    bool labelsMatch = true;
+
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < cols; c++) {
+        cv::uint64 l = labelAt(L, r, c);
+
+        if (l != cv::uint64(labels[r * cols + c]))
+          labelsMatch = false;
+
+        if (l < cv::uint64(count))
+          addPixel(swept[l], r, c);
+      }
+    }
+
+    for (int l = 0; l < count; l++) {
+      if (swept[l].area != 0) {
+        swept[l].centroid_x = swept[l].integral_x / double(swept[l].area);
+        swept[l].centroid_y = swept[l].integral_y / double(swept[l].area);
+      }
+    }
+
+    bool statsMatch = count == expected && int(stats.size()) == count;
+
+    for (int l = 0; statsMatch && l < count; l++)
+      statsMatch = sameStats(stats[l], swept[l]);
+
+    checks++;
+
+    if (count != expected || !labelsMatch || !statsMatch) {
+      failures++;
+      std::printf("mismatch: %dx%d, connectivity %d, label type %d, "
+                  "%d components instead of %d%s%s\n",
+                  rows, cols, connectivity, type, count, expected,
+                  labelsMatch ? "" : ", labels differ",
+                  statsMatch ? "" : ", statistics differ");
+    }
+  }
+
+  std::printf("%d of %d images differ\n", failures, checks);
+
+  return failures == 0 ? 0 : 1;
+}
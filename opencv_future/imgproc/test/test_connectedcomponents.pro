@@ -0,0 +1,23 @@
+# Parity check of the labeling, run the resulting binary: it exits with 0
+# when every image matches.
+
+QT       -= core gui
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = test_connectedcomponents
+TEMPLATE = app
+
+INCLUDEPATH += ../../..
+
+win32 {
+  LIBS    += -lopencv_core242.dll
+}
+
+unix {
+  LIBS    += -lopencv_core
+}
+
+SOURCES += test_connectedcomponents.cpp \
+    ../src/connectedcomponents.cpp
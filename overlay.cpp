@@ -0,0 +1,287 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "overlay.h"
+
+#include <QFontMetrics>
+#include <QPainter>
+
+#include <cmath>
+
+namespace {
+  QPointF map(QPoint const& p, QPoint const& origin, qreal zoom)
+  {
+    return QPointF(origin) + QPointF(p) * zoom;
+  }
+
+  QRect bounds(QLine const& line)
+  {
+    return QRect(line.p1(), line.p2()).normalized();
+  }
+}
+
+OverlayGrid::OverlayGrid()
+{
+}
+
+void OverlayGrid::clear()
+{
+  cells.clear();
+  large.clear();
+  boxes.clear();
+}
+
+qint64 OverlayGrid::key(int x, int y)
+{
+  return (qint64(y) << 32) | quint32(x);
+}
+
+void OverlayGrid::insert(int item, QRect const& box)
+{
+  if (boxes.size() <= item)
+    boxes.resize(item + 1);
+
+  boxes[item] = box;
+
+  if (box.width() > cellSize || box.height() > cellSize)
+    large.append(item);
+  else
+    cells[key(std::floor(box.left() / qreal(cellSize)),
+              std::floor(box.top() / qreal(cellSize)))].append(item);
+}
+
+void OverlayGrid::remove(int item, QRect const& box)
+{
+  if (box.width() > cellSize || box.height() > cellSize) {
+    large.remove(large.lastIndexOf(item));
+  } else {
+    QVector<int>& cell = cells[key(std::floor(box.left() / qreal(cellSize)),
+                                   std::floor(box.top() / qreal(cellSize)))];
+
+    cell.remove(cell.lastIndexOf(item));
+  }
+}
+
+void OverlayGrid::query(QRectF const& area, QVector<int>& items) const
+{
+  items.clear();
+
+  int left = std::floor(area.left() / cellSize) - 1;
+  int top = std::floor(area.top() / cellSize) - 1;
+  int right = std::floor(area.right() / cellSize);
+  int bottom = std::floor(area.bottom() / cellSize);
+
+  // A view larger than the grid is cheaper to answer from the cells that
+  // exist than from the cells it covers.
+  if (qreal(right - left + 1) * (bottom - top + 1) > cells.size()) {
+    QHash<qint64, QVector<int> >::const_iterator i;
+
+    for (i = cells.constBegin(); i != cells.constEnd(); ++i)
+      for (int j = 0; j < i.value().size(); j++)
+        if (QRectF(boxes.at(i.value().at(j))).adjusted(0, 0, 1, 1)
+            .intersects(area))
+          items.append(i.value().at(j));
+  } else {
+    for (int y = top; y <= bottom; y++) {
+      for (int x = left; x <= right; x++) {
+        QHash<qint64, QVector<int> >::const_iterator i =
+            cells.constFind(key(x, y));
+
+        if (i == cells.constEnd())
+          continue;
+
+        for (int j = 0; j < i.value().size(); j++)
+          if (QRectF(boxes.at(i.value().at(j))).adjusted(0, 0, 1, 1)
+              .intersects(area))
+            items.append(i.value().at(j));
+      }
+    }
+  }
+
+  for (int j = 0; j < large.size(); j++)
+    if (QRectF(boxes.at(large.at(j))).adjusted(0, 0, 1, 1).intersects(area))
+      items.append(large.at(j));
+}
+
+Overlay::Overlay() :
+  color(Qt::red),
+  highlighted(0)
+{
+}
+
+void Overlay::clear()
+{
+  lines.clear();
+  texts.clear();
+  rects.clear();
+  particles.clear();
+  highlighted = 0;
+
+  lineGrid.clear();
+  textGrid.clear();
+  rectGrid.clear();
+  particleGrid.clear();
+}
+
+bool Overlay::isEmpty() const
+{
+  return lines.isEmpty() && texts.isEmpty() && rects.isEmpty();
+}
+
+void Overlay::addLine(QLine const& line)
+{
+  lineGrid.insert(lines.size(), bounds(line));
+  lines.append(line);
+}
+
+void Overlay::addText(Text const& text)
+{
+  textGrid.insert(texts.size(), QRect(text.p, QSize(1, 1)));
+  texts.append(text);
+}
+
+void Overlay::addRect(QRect const& rect)
+{
+  rectGrid.insert(rects.size(), rect);
+  rects.append(rect);
+}
+
+void Overlay::removeLastRect()
+{
+  if (!rects.isEmpty()) {
+    rectGrid.remove(rects.size() - 1, rects.last());
+    rects.pop_back();
+  }
+}
+
+void Overlay::addParticle(QRect const& box, Text const& label)
+{
+  particleGrid.insert(particles.size(), box);
+  particles.append(box);
+
+  addText(label);
+}
+
+// When bounding boxes overlap, the smallest particle wins, since it is the
+// one that is hard to click otherwise. Returns 0 when there is none.
+int Overlay::particleAt(QPoint const& p) const
+{
+  QVector<int> candidates;
+  particleGrid.query(QRectF(p, QSizeF(1, 1)), candidates);
+
+  int particle = 0;
+  qint64 area = 0;
+
+  for (int i = 0; i < candidates.size(); i++) {
+    QRect const& box = particles.at(candidates.at(i));
+    qint64 a = qint64(box.width()) * box.height();
+
+    if (box.contains(p) && (particle == 0 || a < area)) {
+      particle = candidates.at(i) + 1;
+      area = a;
+    }
+  }
+
+  return particle;
+}
+
+void Overlay::highlightParticle(int particle)
+{
+  highlighted = particle;
+}
+
+// Every kind of primitive is looked up in its grid and then drawn with a
+// single call. When the labels would cover a good part of the exposed area
+// they are unreadable anyway, so they are drawn as dots.
+void Overlay::paint(QPainter& painter,
+                    QRect const& exposed,
+                    QPoint const& origin,
+                    qreal zoom) const
+{
+  if (isEmpty() || exposed.isEmpty() || zoom <= 0)
+    return;
+
+  QRectF view(QPointF(exposed.topLeft() - origin) / zoom,
+              QSizeF(exposed.size()) / zoom);
+
+  QColor pen(color);
+  QColor brush(color);
+  pen.setAlpha(128);
+  brush.setAlpha(64);
+
+  painter.save();
+  painter.setClipRect(exposed);
+  painter.setPen(pen);
+
+  QVector<int> visible;
+
+  lineGrid.query(view.adjusted(-1, -1, 1, 1), visible);
+
+  QVector<QLineF> lineSegments(visible.size());
+  for (int i = 0; i < visible.size(); i++)
+    lineSegments[i] = QLineF(map(lines.at(visible.at(i)).p1(), origin, zoom),
+                             map(lines.at(visible.at(i)).p2(), origin, zoom));
+
+  painter.drawLines(lineSegments);
+
+  QFontMetrics metrics(painter.font());
+  qreal labelWidth = metrics.width(QLatin1String("00000"));
+  qreal labelHeight = metrics.height();
+
+  textGrid.query(view.adjusted(-labelWidth / zoom, -labelHeight / zoom,
+                               labelWidth / zoom, labelHeight / zoom),
+                 visible);
+
+  if (visible.size() * labelWidth * labelHeight >
+      exposed.width() * exposed.height() / 4.0) {
+    QVector<QPointF> dots(visible.size());
+
+    for (int i = 0; i < visible.size(); i++)
+      dots[i] = map(texts.at(visible.at(i)).p, origin, zoom);
+
+    painter.setPen(QPen(pen, 3));
+    painter.drawPoints(dots);
+    painter.setPen(pen);
+  } else {
+    for (int i = 0; i < visible.size(); i++)
+      painter.drawText(map(texts.at(visible.at(i)).p, origin, zoom),
+                       texts.at(visible.at(i)).s);
+  }
+
+  rectGrid.query(view.adjusted(-1, -1, 1, 1), visible);
+
+  QVector<QRectF> boxes(visible.size());
+  for (int i = 0; i < visible.size(); i++)
+    boxes[i] = QRectF(map(rects.at(visible.at(i)).topLeft(), origin, zoom),
+                      map(rects.at(visible.at(i)).bottomRight(), origin, zoom));
+
+  painter.setBrush(brush);
+  painter.drawRects(boxes);
+
+  if (highlighted > 0 && highlighted <= particles.size()) {
+    QRect const& box = particles.at(highlighted - 1);
+
+    painter.setPen(QPen(Qt::yellow, 2));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(QRectF(map(box.topLeft(), origin, zoom),
+                            map(box.bottomRight() + QPoint(1, 1), origin, zoom)));
+  }
+
+  painter.restore();
+}
@@ -0,0 +1,101 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QColor>
+#include <QHash>
+#include <QLine>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+class QPainter;
+
+struct Text {
+    QPoint p;
+    QString s;
+};
+
+// Uniform grid over the bounding boxes of the overlay items. The cells are
+// hashed, so the grid doesn't depend on the image size. An item is stored in
+// the cell of its top left corner; items larger than a cell are kept apart
+// and always tested, so a query only visits the cells it covers plus one row
+// and one column before them.
+class OverlayGrid
+{
+  public:
+    OverlayGrid();
+
+    void clear();
+    void insert(int item, QRect const& box);
+    void remove(int item, QRect const& box);
+    void query(QRectF const& area, QVector<int>& items) const;
+
+  private:
+    static int const cellSize = 64;
+
+    QHash<qint64, QVector<int> > cells;
+    QVector<int> large;
+    QVector<QRect> boxes;
+
+    static qint64 key(int x, int y);
+};
+
+// Measurements drawn over an image, stored in image coordinates.
+class Overlay
+{
+  public:
+    Overlay();
+
+    QColor color;
+
+    void clear();
+    bool isEmpty() const;
+
+    void addLine(QLine const& line);
+    void addText(Text const& text);
+    void addRect(QRect const& rect);
+    void removeLastRect();
+
+    // The particles are numbered from 1, in the order they are added.
+    void addParticle(QRect const& box, Text const& label);
+    int particleAt(QPoint const& p) const;
+    void highlightParticle(int particle);
+
+    // Draws the primitives inside the exposed area, given in widget
+    // coordinates, for an image placed at origin and scaled by zoom.
+    void paint(QPainter& painter,
+               QRect const& exposed,
+               QPoint const& origin,
+               qreal zoom) const;
+
+  private:
+    QVector<QLine> lines;
+    QVector<Text> texts;
+    QVector<QRect> rects;
+    QVector<QRect> particles;
+    int highlighted;
+
+    OverlayGrid lineGrid;
+    OverlayGrid textGrid;
+    OverlayGrid rectGrid;
+    OverlayGrid particleGrid;
+};
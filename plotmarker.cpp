@@ -0,0 +1,87 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "plotmarker.h"
+
+#include <QEvent>
+#include <QPainter>
+
+#include <qwt_plot.h>
+#include <qwt_plot_canvas.h>
+
+PlotMarker::PlotMarker(QwtPlot *plot) :
+  QWidget(plot->canvas()),
+  plot(plot),
+  color(Qt::red),
+  x(-1)
+{
+  setAttribute(Qt::WA_TransparentForMouseEvents);
+  setAttribute(Qt::WA_NoSystemBackground);
+
+  resize(plot->canvas()->size());
+  plot->canvas()->installEventFilter(this);
+
+  show();
+}
+
+// The value is given in the units of the bottom axis.
+void PlotMarker::setValue(double value)
+{
+  int newX = qRound(plot->transform(QwtPlot::xBottom, value));
+
+  if (newX == x)
+    return;
+
+  update(lineRect(x));
+  x = newX;
+  update(lineRect(x));
+}
+
+void PlotMarker::clear()
+{
+  update(lineRect(x));
+  x = -1;
+}
+
+bool PlotMarker::eventFilter(QObject *object, QEvent *event)
+{
+  if (object == plot->canvas() && event->type() == QEvent::Resize)
+    resize(plot->canvas()->size());
+
+  return QWidget::eventFilter(object, event);
+}
+
+void PlotMarker::paintEvent(QPaintEvent *)
+{
+  if (x < 0)
+    return;
+
+  QPainter painter(this);
+
+  painter.setPen(color);
+  painter.drawLine(x, 0, x, height() - 1);
+}
+
+QRect PlotMarker::lineRect(int x) const
+{
+  if (x < 0)
+    return QRect();
+
+  return QRect(x - 1, 0, 3, height());
+}
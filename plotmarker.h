@@ -0,0 +1,48 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QColor>
+#include <QWidget>
+
+class QwtPlot;
+
+// A vertical line drawn over the canvas of a plot. Moving it only repaints
+// the pixels under the old and the new line, the plot is never replotted.
+class PlotMarker : public QWidget
+{
+    Q_OBJECT
+  public:
+    explicit PlotMarker(QwtPlot *plot);
+
+    void setValue(double value);
+    void clear();
+
+  protected:
+    bool eventFilter(QObject *object, QEvent *event);
+    void paintEvent(QPaintEvent *);
+
+  private:
+    QwtPlot *plot;
+    QColor color;
+    int x;
+
+    QRect lineRect(int x) const;
+};
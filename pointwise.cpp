@@ -0,0 +1,222 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pointwise.h"
+
+#include "lookuptable.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+  // Eight bytes per load and store
+  void invertBytes(Band& band)
+  {
+    quint64 const ones = ~quint64(0);
+
+    for (int i = band.first; i < band.last; i++) {
+      uchar const* p = band.src->ptr<uchar>(i);
+      uchar* q = band.result->ptr<uchar>(i);
+      size_t j = band.begin;
+
+      for (; j + 8 <= band.end; j += 8) {
+        quint64 word;
+        std::memcpy(&word, p + j, 8);
+        word ^= ones;
+        std::memcpy(q + j, &word, 8);
+      }
+
+      for (; j < band.end; j++)
+        q[j] = uchar(~p[j]);
+    }
+  }
+
+  template<typename T>
+  void invertUnits(Band& band)
+  {
+    for (int i = band.first; i < band.last; i++) {
+      T const* p = reinterpret_cast<T const*>(band.src->ptr<uchar>(i) + band.begin);
+      T* q = reinterpret_cast<T*>(band.result->ptr<uchar>(i) + band.begin);
+      size_t const n = (band.end - band.begin) / sizeof(T);
+
+      for (size_t j = 0; j < n; j++)
+        q[j] = 1 - p[j];
+    }
+  }
+
+  void invertBand(Band& band)
+  {
+    switch (band.src->depth()) {
+      case CV_32F:
+        invertUnits<float>(band);
+        break;
+      case CV_64F:
+        invertUnits<double>(band);
+        break;
+      default:
+        invertBytes(band);
+        break;
+    }
+  }
+
+  struct Planes {
+      std::vector<cv::Mat> const* images;
+      std::vector<int> const* channels;
+      std::vector<LookupTable> const* luts;
+  };
+
+  // Each pixel of the result is written whole. A continuous result is a
+  // single row, so a band is walked in runs that stay within a row of the
+  // sources, whose rows are found at the start of each run.
+  void mergeBand(Band& band)
+  {
+    Planes const& planes = *static_cast<Planes const*>(band.data);
+    int const n = int(planes.images->size());
+    size_t const width = size_t(band.result->cols);
+    size_t cols = 0;
+
+    std::vector<uchar const*> rows(n);
+    std::vector<int> steps(n);
+
+    for (int k = 0; k < n; k++) {
+      steps[k] = planes.images->at(k).channels();
+
+      if (!planes.images->at(k).empty())
+        cols = size_t(planes.images->at(k).cols);
+    }
+
+    for (int i = band.first; i < band.last; i++) {
+      size_t x = band.begin / n;
+      size_t const end = band.end / n;
+      uchar* q = band.result->ptr<uchar>(i) + x * n;
+
+      while (x < end) {
+        size_t const pixel = i * width + x;
+        int const row = int(pixel / cols);
+        size_t const col = pixel % cols;
+        size_t const length = std::min(end - x, cols - col);
+
+        for (int k = 0; k < n; k++) {
+          cv::Mat const& image = planes.images->at(k);
+
+          rows[k] = image.empty() ? 0 : image.ptr<uchar>(row) +
+                                        col * steps[k] +
+                                        planes.channels->at(k);
+        }
+
+        for (size_t j = 0; j < length; j++, q += n) {
+          for (int k = 0; k < n; k++) {
+            uchar const* p = rows[k];
+
+            q[k] = p ? planes.luts->at(k)[p[j * steps[k]]] : 0;
+          }
+        }
+
+        x += length;
+      }
+    }
+  }
+}
+
+// At most four bands per thread, a single row gets bands of 64 kB or more
+void runBands(cv::Mat const& src,
+              cv::Mat& result,
+              size_t unit,
+              void (*kernel)(Band&),
+              void const* data)
+{
+  bool const continuous = src.isContinuous() && result.isContinuous();
+  int const rows = continuous ? 1 : src.rows;
+  size_t const length = (continuous ? src.total() : size_t(src.cols)) *
+                        src.elemSize();
+  int const count = qBound(1, 4 * QThread::idealThreadCount(),
+                           std::max(rows, int(length >> 16)));
+
+  // A continuous image is read as one row of its whole size
+  cv::Mat s = continuous ? src.reshape(0, 1) : src;
+  cv::Mat r = continuous ? result.reshape(0, 1) : result;
+
+  QVector<Band> bands;
+
+  for (int k = 0; k < count; k++) {
+    Band band;
+
+    band.src = &s;
+    band.result = &r;
+    band.data = data;
+
+    if (rows == 1) {
+      band.first = 0;
+      band.last = 1;
+      band.begin = length * k / count / unit * unit;
+      band.end = k + 1 == count ? length : length * (k + 1) / count / unit * unit;
+    } else {
+      band.first = k * rows / count;
+      band.last = (k + 1) * rows / count;
+      band.begin = 0;
+      band.end = length;
+    }
+
+    bands.append(band);
+  }
+
+  QtConcurrent::blockingMap(bands, kernel);
+}
+
+// Integer values are inverted eight bytes at a time, float values one by one
+void invertImage(cv::Mat const& src, cv::Mat& result)
+{
+  result.create(src.size(), src.type());
+
+  if (!src.empty())
+    runBands(src, result, std::max(size_t(8), src.elemSize1()), invertBand);
+}
+
+void mergeChannels(std::vector<cv::Mat> const& images,
+                   std::vector<int> const& channels,
+                   std::vector<LookupTable> const& luts,
+                   cv::Mat& result)
+{
+  cv::Size size;
+
+  for (size_t k = 0; k < images.size(); k++)
+    if (!images[k].empty())
+      size = images[k].size();
+
+  result.create(size, CV_8UC(int(images.size())));
+
+  if (result.empty())
+    return;
+
+  Planes planes;
+
+  planes.images = &images;
+  planes.channels = &channels;
+  planes.luts = &luts;
+
+  // Whole pixels per band. The result is split, the sources are read where
+  // its pixels fall.
+  runBands(result, result, result.elemSize(), mergeBand, &planes);
+}
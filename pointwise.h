@@ -0,0 +1,66 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class LookupTable;
+
+namespace cv {
+  class Mat;
+}
+
+// A range of rows of an image and of its result, and of bytes within each of
+// them. data is whatever else the kernel reads.
+struct Band {
+    cv::Mat const* src;
+    cv::Mat* result;
+    void const* data;
+    int first;
+    int last;
+    size_t begin;
+    size_t end;
+};
+
+// Maps kernel over bands of src and result, which has the same size, on the
+// global thread pool. Continuous images are a single row split in bands of
+// bytes, a multiple of unit long; others are split in bands of rows.
+void runBands(cv::Mat const& src,
+              cv::Mat& result,
+              size_t unit,
+              void (*kernel)(Band&),
+              void const* data = 0);
+
+// Pointwise kernels over whole images, of any depth and number of channels.
+// result may be src, the image is then changed in place.
+
+// Integer values get all their bits flipped, so each depth's range is
+// mirrored onto itself. Float values are taken to be in [0, 1].
+void invertImage(cv::Mat const& src, cv::Mat& result);
+
+// Interleaves 8 bits planes of the same size into an image with a channel
+// per plane, each plane going through its table on the way. A plane is read
+// in place from one channel of its image; an empty image gives a channel of
+// zeros.
+void mergeChannels(std::vector<cv::Mat> const& images,
+                   std::vector<int> const& channels,
+                   std::vector<LookupTable> const& luts,
+                   cv::Mat& result);
@@ -0,0 +1,183 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "regionhistogram.h"
+
+#include <algorithm>
+
+namespace {
+  // Prefix sums bigger than this use larger tiles
+  size_t const maxIntegralSize = 1 << 22;
+}
+
+RegionHistogram::RegionHistogram(cv::Mat const& image) :
+  image(image),
+  numberOfBins(256),
+  min(0),
+  max(256),
+  tileSize(32)
+{
+  if (image.depth() != CV_8U && !image.empty()) {
+    cv::Mat channel = image;
+
+    if (image.channels() > 1)
+      cv::extractChannel(image, channel, 0);
+
+    cv::minMaxLoc(channel, &min, &max);
+
+    if (max <= min)
+      max = min + 1;
+  }
+
+  a = numberOfBins / (max - min);
+  b = -min * a;
+
+  while (size_t(image.rows / tileSize + 1) * (image.cols / tileSize + 1) *
+         numberOfBins > maxIntegralSize)
+    tileSize *= 2;
+
+  tilesX = image.cols / tileSize;
+  tilesY = image.rows / tileSize;
+
+  integral.assign(size_t(tilesY + 1) * (tilesX + 1) * numberOfBins, 0);
+
+  // Row ty + 1 of the sums starts as the histograms of the tiles of row ty,
+  // then the previous tile and the row above are added.
+  for (int ty = 0; ty < tilesY; ty++) {
+    for (int tx = 0; tx < tilesX; tx++) {
+      unsigned int* tile = &integral[(size_t(ty + 1) * (tilesX + 1) + tx + 1) *
+                                     numberOfBins];
+
+      for (int i = ty * tileSize; i < (ty + 1) * tileSize; i++)
+        countRow(i, tx * tileSize, (tx + 1) * tileSize, tile);
+
+      unsigned int const* left = at(ty + 1, tx);
+      unsigned int const* up = at(ty, tx + 1);
+      unsigned int const* corner = at(ty, tx);
+
+      for (int k = 0; k < numberOfBins; k++)
+        tile[k] += left[k] + up[k] - corner[k];
+    }
+  }
+}
+
+int RegionHistogram::bins() const
+{
+  return numberOfBins;
+}
+
+double RegionHistogram::minimum() const
+{
+  return min;
+}
+
+double RegionHistogram::maximum() const
+{
+  return max;
+}
+
+// Whether every bin holds a single value
+bool RegionHistogram::exact() const
+{
+  return image.depth() == CV_8U;
+}
+
+unsigned int const* RegionHistogram::at(int tileY, int tileX) const
+{
+  return &integral[(size_t(tileY) * (tilesX + 1) + tileX) * numberOfBins];
+}
+
+void RegionHistogram::countRow(int row,
+                               int first,
+                               int last,
+                               unsigned int* counts) const
+{
+  int const cn = image.channels();
+
+  switch (image.depth()) {
+    case CV_8U:
+    {
+      quint8 const* p = image.ptr<quint8>(row);
+
+      for (int j = first; j < last; j++)
+        counts[p[j * cn]]++;
+      break;
+    }
+
+    case CV_16U:
+    {
+      quint16 const* p = image.ptr<quint16>(row);
+
+      for (int j = first; j < last; j++)
+        counts[std::min(cvFloor(p[j * cn] * a + b), numberOfBins - 1)]++;
+      break;
+    }
+
+    case CV_32F:
+    {
+      float const* p = image.ptr<float>(row);
+
+      for (int j = first; j < last; j++) {
+        int bin = cvFloor(p[j * cn] * a + b);
+
+        if (0 <= bin && bin <= numberOfBins)
+          counts[std::min(bin, numberOfBins - 1)]++;
+      }
+      break;
+    }
+  }
+}
+
+void RegionHistogram::histogram(QRect const& rect,
+                                std::vector<unsigned int>& counts) const
+{
+  counts.assign(numberOfBins, 0);
+
+  QRect r = rect.normalized() & QRect(0, 0, image.cols, image.rows);
+
+  if (r.isEmpty())
+    return;
+
+  // Whole tiles inside the rectangle
+  int tx0 = (r.left() + tileSize - 1) / tileSize;
+  int ty0 = (r.top() + tileSize - 1) / tileSize;
+  int tx1 = (r.right() + 1) / tileSize;
+  int ty1 = (r.bottom() + 1) / tileSize;
+
+  if (tx0 < tx1 && ty0 < ty1) {
+    unsigned int const* p11 = at(ty1, tx1);
+    unsigned int const* p01 = at(ty0, tx1);
+    unsigned int const* p10 = at(ty1, tx0);
+    unsigned int const* p00 = at(ty0, tx0);
+
+    for (int k = 0; k < numberOfBins; k++)
+      counts[k] = p11[k] - p01[k] - p10[k] + p00[k];
+  } else {
+    tx0 = tx1 = ty0 = ty1 = 0;
+  }
+
+  for (int i = r.top(); i <= r.bottom(); i++) {
+    if (ty0 * tileSize <= i && i < ty1 * tileSize) {
+      countRow(i, r.left(), tx0 * tileSize, &counts[0]);
+      countRow(i, tx1 * tileSize, r.right() + 1, &counts[0]);
+    } else {
+      countRow(i, r.left(), r.right() + 1, &counts[0]);
+    }
+  }
+}
@@ -0,0 +1,61 @@
+/*
+* Copyright (C) 2012 Jorge Aparicio <jorge.aparicio.r@gmail.com>
+*
+* This file is part of ImageQ.
+*
+* ImageQ is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* ImageQ is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with ImageQ. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QRect>
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+// Histogram of any rectangle of the first channel of an image. The image is
+// split in square tiles and the prefix sums of the tile histograms are kept,
+// so the tiles inside a rectangle cost O(bins) and only the pixels on its
+// border, less than a tile deep, are counted one by one.
+//
+// 8 bits images have a bin per value. 16 bits and float images have 256 bins
+// over the range of their data.
+class RegionHistogram
+{
+  public:
+    explicit RegionHistogram(cv::Mat const& image);
+
+    int bins() const;
+    double minimum() const;
+    double maximum() const;
+    bool exact() const;
+
+    void histogram(QRect const& rect, std::vector<unsigned int>& counts) const;
+
+  private:
+    cv::Mat image;
+    int numberOfBins;
+    double min;
+    double max;
+    double a;
+    double b;
+    int tileSize;
+    int tilesX;
+    int tilesY;
+    std::vector<unsigned int> integral;
+
+    void countRow(int row, int first, int last, unsigned int* counts) const;
+    unsigned int const* at(int tileY, int tileX) const;
+};
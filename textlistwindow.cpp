@@ -20,22 +20,46 @@
 #include "textlistwindow.h"
 #include "ui_textlistwindow.h"
 
+#include "measurementmodel.h"
+
+#include <QDoubleValidator>
 #include <QFileDialog>
+#include <QHeaderView>
 #include <QTextStream>
 
+#include <limits>
+
 TextListWindow::TextListWindow(QString const& title,
-                               QString const& header,
+                               QStringList const& columns,
+                               QStringList const& units,
                                QWidget *parent) :
   QMainWindow(parent),
   ui(new Ui::TextListWindow),
-  text(QStringList()),
-  count(0)
+  model(new MeasurementModel(columns, units, this)),
+  filter(new MeasurementFilter(this))
 {
   ui->setupUi(this);
 
   this->setWindowTitle(title);
 
-  ui->headerLabel->setText(header);
+  filter->setSourceModel(model);
+  filter->setDynamicSortFilter(true);
+
+  ui->tableView->setModel(filter);
+  ui->tableView->setSortingEnabled(true);
+  ui->tableView->sortByColumn(0, Qt::AscendingOrder);
+
+  // Every row has the same height, so the view doesn't have to measure them
+  ui->tableView->verticalHeader()->setResizeMode(QHeaderView::Fixed);
+  ui->tableView->verticalHeader()->hide();
+
+  ui->filterComboBox->blockSignals(true);
+  ui->filterComboBox->addItem(QLatin1String("None"));
+  ui->filterComboBox->addItems(columns);
+  ui->filterComboBox->blockSignals(false);
+
+  ui->minLineEdit->setValidator(new QDoubleValidator(this));
+  ui->maxLineEdit->setValidator(new QDoubleValidator(this));
 
   this->setAttribute(Qt::WA_DeleteOnClose);
   this->show();
@@ -46,18 +70,25 @@ TextListWindow::~TextListWindow()
   delete ui;
 }
 
-void TextListWindow::append(QString const& s)
+void TextListWindow::append(QVector<double> const& values)
 {
-  count++;
+  model->append(values);
+}
 
-  text << s;
+// Rows are numbered in the order they were appended, whatever the sorting.
+void TextListWindow::select(int row)
+{
+  QModelIndex index = filter->mapFromSource(model->index(row, 0));
 
-  ui->textLabel->setText(text.join(QString('\n')));
+  if (index.isValid()) {
+    ui->tableView->selectRow(index.row());
+    ui->tableView->scrollTo(index);
+  }
 }
 
 int TextListWindow::size() const
 {
-  return count;
+  return model->rowCount();
 }
 
 void TextListWindow::on_savePushButton_clicked()
@@ -67,6 +98,9 @@ void TextListWindow::on_savePushButton_clicked()
                                                   QString(),
                                                   "Text Files (*.txt)");
 
+  if (filename.isEmpty())
+    return;
+
   if (!filename.endsWith(".txt"))
     filename += ".txt";
 
@@ -74,7 +108,21 @@ void TextListWindow::on_savePushButton_clicked()
   f.open(QIODevice::WriteOnly);
   QTextStream stream(&f);
 
-  stream << ui->headerLabel->text() + "\n" + text.join("\n");
+  int measurements = model->measurements();
+
+  for (int j = 0; j < measurements; j++)
+    stream << (j ? "\t" : "") << model->headerData(j, Qt::Horizontal)
+                                      .toString();
+
+  // The rows are written as they are shown, one at a time
+  for (int i = 0; i < filter->rowCount(); i++) {
+    int row = filter->mapToSource(filter->index(i, 0)).row();
+
+    stream << '\n';
+
+    for (int j = 0; j < measurements; j++)
+      stream << (j ? "\t" : "") << QString::number(model->value(row, j));
+  }
 
   f.close();
 
@@ -85,3 +133,35 @@ void TextListWindow::on_closePushButton_clicked()
 {
   this->close();
 }
+
+void TextListWindow::on_filterComboBox_currentIndexChanged(int)
+{
+  applyFilter();
+}
+
+void TextListWindow::on_minLineEdit_editingFinished()
+{
+  applyFilter();
+}
+
+void TextListWindow::on_maxLineEdit_editingFinished()
+{
+  applyFilter();
+}
+
+void TextListWindow::applyFilter()
+{
+  double min = -std::numeric_limits<double>::infinity();
+  double max = std::numeric_limits<double>::infinity();
+  bool ok;
+
+  double value = ui->minLineEdit->text().toDouble(&ok);
+  if (ok)
+    min = value;
+
+  value = ui->maxLineEdit->text().toDouble(&ok);
+  if (ok)
+    max = value;
+
+  filter->setRange(ui->filterComboBox->currentIndex() - 1, min, max);
+}
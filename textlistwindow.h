@@ -20,6 +20,11 @@
 #pragma once
 
 #include <QMainWindow>
+#include <QStringList>
+#include <QVector>
+
+class MeasurementFilter;
+class MeasurementModel;
 
 namespace Ui {
   class TextListWindow;
@@ -31,10 +36,12 @@ class TextListWindow : public QMainWindow
     
   public:
     explicit TextListWindow(QString const& title,
-                            QString const& header,
+                            QStringList const& columns,
+                            QStringList const& units,
                             QWidget *parent = 0);
     ~TextListWindow();
-    void append(QString const& s);
+    void append(QVector<double> const& values);
+    void select(int row);
     int size() const;
     
   private slots:
@@ -42,8 +49,14 @@ class TextListWindow : public QMainWindow
 
     void on_closePushButton_clicked();
 
+    void on_filterComboBox_currentIndexChanged(int);
+    void on_minLineEdit_editingFinished();
+    void on_maxLineEdit_editingFinished();
+
   private:
     Ui::TextListWindow *ui;
-    QStringList text;
-    int count;
+    MeasurementModel *model;
+    MeasurementFilter *filter;
+
+    void applyFilter();
 };
@@ -20,25 +20,33 @@
 #include "thresholdwindow.h"
 #include "ui_thresholdwindow.h"
 
+#include "componenttree.h"
 #include "image.h"
+#include "lookuptable.h"
+#include "plotmarker.h"
 
 #include <opencv2/imgproc/imgproc.hpp>
 
-#include <qwt_plot_marker.h>
+#include <qwt_plot_histogram.h>
 
 ThresholdWindow::ThresholdWindow(Image* image,
                                  QWidget *parent) :
   QMainWindow(parent),
   ui(new Ui::ThresholdWindow),
   image(image),
-  histogram(image->current, 256),
-  yAxis(0),
+  histogram(image->histogram(), 256),
+  marker(0),
+  areas(new QwtPlotHistogram),
+  tree(0),
+  invertedTree(0),
   abort(true)
 {
   ui->setupUi(this);
 
   image->backup();
 
+  tree = new ComponentTree(image->previous);
+
   connect(this,   SIGNAL(update()),
           image,  SLOT(update()));
 
@@ -52,18 +60,40 @@ ThresholdWindow::ThresholdWindow(Image* image,
 
   this->setAttribute(Qt::WA_DeleteOnClose);
 
+  QColor color(Qt::darkGreen);
+
+  color.setAlpha(0);
+  areas->setPen(QPen(color));
+  color.setAlpha(96);
+  areas->setBrush(QBrush(color));
+  areas->attach(ui->areasPlot);
+
+  ui->areasPlot->setAxisAutoScale(QwtPlot::xBottom, false);
+  ui->areasPlot->setAxisScale(QwtPlot::xBottom, 0, ComponentTree::areaBins);
+
+  ui->areasPlot->enableAxis(QwtPlot::xBottom, false);
+  ui->areasPlot->enableAxis(QwtPlot::yLeft, false);
+
   ui->histogramPlot->setFixedSize(480, 200);
+  ui->areasPlot->setFixedSize(480, 100);
+  histogram.setPlotWidth(480);
   ui->adaptativeFrame->hide();
   this->adjustSize();
   this->setFixedSize(this->size());
 
   this->show();
 
+  // Created after the layout settled, the marker takes the size of the
+  // canvas.
+  marker = new PlotMarker(ui->histogramPlot);
+
   threshold();
 }
 
 ThresholdWindow::~ThresholdWindow()
 {
+  delete tree;
+  delete invertedTree;
   delete ui;
 }
 
@@ -87,21 +117,9 @@ void ThresholdWindow::on_okPushButton_clicked()
 
 void ThresholdWindow::on_thresholdSlider_sliderMoved(int value)
 {
-  if (yAxis)  {
-    delete yAxis;
-    yAxis = 0;
-  }
-
-  if (!ui->adaptativeCheckBox->isChecked()) {
-    yAxis = new QwtPlotMarker;
+  if (!ui->adaptativeCheckBox->isChecked())
+    marker->setValue(value + 0.5);
 
-    yAxis->setLineStyle(QwtPlotMarker::VLine);
-    yAxis->setLinePen(QPen(Qt::red));
-    yAxis->setXValue(value + 0.5);
-    yAxis->attach(ui->histogramPlot);
-
-    ui->histogramPlot->replot();
-  }
   threshold();
 }
 
@@ -110,12 +128,7 @@ void ThresholdWindow::on_adaptativeCheckBox_toggled(bool checked)
   ui->otsuCheckBox->setDisabled(checked);
 
   if (checked) {
-    if (yAxis)  {
-      delete yAxis;
-      yAxis = 0;
-
-      ui->histogramPlot->replot();
-    }
+    marker->clear();
 
     ui->otsuCheckBox->setChecked(false);
 
@@ -186,6 +199,8 @@ void ThresholdWindow::on_truncateRadioButton_toggled(bool checked)
 
 void ThresholdWindow::threshold()
 {
+  image->detach();
+
   if (ui->adaptativeCheckBox->isChecked()) {
     int method = 0;
     int type = 0;
@@ -208,6 +223,8 @@ void ThresholdWindow::threshold()
                           ui->sizeSpinBox->value(),
                           ui->thresholdSlider->value()
                           );
+
+    countParticles(-1, false);
   } else {
     int type = 0;
 
@@ -228,11 +245,23 @@ void ThresholdWindow::threshold()
     if (ui->otsuCheckBox->isChecked())
       type |= cv::THRESH_OTSU;
 
-    cv::threshold(image->previous,
-                  image->current,
-                  ui->thresholdSlider->value(),
-                  255.0,
-                  type);
+    double value = ui->thresholdSlider->value();
+
+    // Otsu picks the value from the image and tables only map 8 bits images
+    if (type & cv::THRESH_OTSU || image->previous.depth() != CV_8U)
+      value = cv::threshold(image->previous,
+                            image->current,
+                            value,
+                            255.0,
+                            type);
+    else
+      LookupTable::threshold(int(value), 255, type).apply(image->previous,
+                                                          image->current);
+
+    if (ui->binaryRadioButton->isChecked())
+      countParticles(int(value), ui->invertedCheckBox->isChecked());
+    else
+      countParticles(-1, false);
   }
 
   emit update();
@@ -242,3 +271,40 @@ void ThresholdWindow::on_sizeSpinBox_valueChanged(int)
 {
   threshold();
 }
+
+// The particles are the 8-connected white areas of the binary threshold, the
+// same ones the Particles analysis finds. They come from the component trees,
+// so moving the slider doesn't relabel the image. A negative value clears the
+// count.
+void ThresholdWindow::countParticles(int value, bool inverted)
+{
+  if (value < 0) {
+    ui->particlesLabel->clear();
+    areas->setData(new QwtIntervalSeriesData(QVector<QwtIntervalSample>()));
+    ui->areasPlot->replot();
+
+    return;
+  }
+
+  ComponentTree const* source = tree;
+
+  // src <= value is the same as 255 - src > 254 - value
+  if (inverted) {
+    if (!invertedTree)
+      invertedTree = new ComponentTree(255 - image->previous);
+
+    source = invertedTree;
+    value = 254 - value;
+  }
+
+  std::vector<int> distribution = source->areaDistribution(value);
+  QVector<QwtIntervalSample> samples(ComponentTree::areaBins);
+
+  for (int i = 0; i < ComponentTree::areaBins; i++)
+    samples[i] = QwtIntervalSample(distribution[i], QwtInterval(i, i + 1));
+
+  areas->setData(new QwtIntervalSeriesData(samples));
+  ui->areasPlot->replot();
+
+  ui->particlesLabel->setText(tr("Particles: %1").arg(source->count(value)));
+}
@@ -23,9 +23,11 @@
 
 #include "histogram.h"
 
+class ComponentTree;
 class Image;
+class PlotMarker;
 
-class QwtPlotMarker;
+class QwtPlotHistogram;
 
 namespace Ui {
   class ThresholdWindow;
@@ -68,8 +70,12 @@ class ThresholdWindow : public QMainWindow
     Ui::ThresholdWindow *ui;
     Image* image;
     Histogram histogram;
-    QwtPlotMarker *yAxis;
+    PlotMarker *marker;
+    QwtPlotHistogram *areas;
+    ComponentTree *tree;
+    ComponentTree *invertedTree;
     bool abort;
 
     void threshold();
+    void countParticles(int, bool);
 };